@@ -1,5 +1,7 @@
 #pragma once
 
+#include "fixfmt/analyze.hh"
+#include "fixfmt/arrow.hh"
 #include "fixfmt/bool.hh"
 #include "fixfmt/table.hh"
 #include "fixfmt/number.hh"
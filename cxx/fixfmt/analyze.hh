@@ -0,0 +1,1018 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "fixfmt/base.hh"
+#include "fixfmt/double-conversion/double-conversion.h"
+#include "fixfmt/math.hh"
+#include "fixfmt/parallel.hh"
+#include "fixfmt/text.hh"
+
+//------------------------------------------------------------------------------
+
+namespace fixfmt {
+
+/*
+ * Properties of an array of floating point values, for choosing a formatter.
+ */
+template<typename TYPE>
+struct FloatAnalysis
+{
+  bool has_nan = false;
+  bool has_pos_inf = false;
+  bool has_neg_inf = false;
+  // Number of values that are neither NaN nor infinite.
+  long num = 0;
+  // Min and max, excluding NaN and infinity.
+  TYPE min = std::numeric_limits<TYPE>::max();
+  TYPE max = std::numeric_limits<TYPE>::min();
+  // Fractional digits needed to show the values exactly, up to a maximum.
+  int precision = 0;
+};
+
+
+/*
+ * Properties of an array of integer values, for choosing a formatter.
+ */
+template<typename TYPE>
+struct IntAnalysis
+{
+  long num = 0;
+  TYPE min = std::numeric_limits<TYPE>::max();
+  TYPE max = std::numeric_limits<TYPE>::min();
+  // Digits in the value of largest magnitude, at least one.
+  int digits = 1;
+};
+
+
+namespace analyze {
+
+using DTSC = double_conversion::DoubleToStringConverter;
+
+template<typename TYPE> struct FloatTraits;
+
+template<>
+struct FloatTraits<double>
+{
+  using Bits = uint64_t;
+  static constexpr int MANTISSA_BITS = 52;
+  static constexpr int EXPONENT_BIAS = 1023;
+  static constexpr int EXPONENT_MASK = 0x7ff;
+  // Most significant digits in a shortest round-trip representation.
+  static constexpr int MAX_DIGITS = 17;
+  // Largest power of ten that is exact, and in the table of 'pow10()'.
+  static constexpr int MAX_EXACT_POW10 = 19;
+  static constexpr auto MODE = DTSC::SHORTEST;
+};
+
+template<>
+struct FloatTraits<float>
+{
+  using Bits = uint32_t;
+  static constexpr int MANTISSA_BITS = 23;
+  static constexpr int EXPONENT_BIAS = 127;
+  static constexpr int EXPONENT_MASK = 0xff;
+  static constexpr int MAX_DIGITS = 9;
+  static constexpr int MAX_EXACT_POW10 = 10;
+  static constexpr auto MODE = DTSC::SHORTEST_SINGLE;
+};
+
+
+/*
+ * Returns the number of decimal digits in `val`, at least one.
+ */
+inline int
+num_digits(
+  unsigned long val)
+{
+  int digits = 1;
+  for (; val >= 10; val /= 10)
+    ++digits;
+  return digits;
+}
+
+
+/*
+ * Returns the number of fractional digits in the shortest round-trip
+ * representation of `val`.  This is the slow path.
+ */
+template<typename TYPE>
+inline int
+get_precision(
+  TYPE const val)
+{
+  char buf[384];  // Enough room for DBL_MAX.
+  bool sign;
+  int length;
+  int decimal_pos;
+  DTSC::DoubleToAscii(
+    std::abs(val), FloatTraits<TYPE>::MODE, 0, buf, sizeof(buf), &sign,
+    &length, &decimal_pos);
+  return length - decimal_pos;
+}
+
+
+/*
+ * Returns an upper bound on the precision of finite `val`, from its exponent.
+ */
+template<typename TYPE>
+inline int
+get_max_precision(
+  TYPE const val)
+{
+  using Traits = FloatTraits<TYPE>;
+
+  typename Traits::Bits bits;
+  memcpy(&bits, &val, sizeof(bits));
+  int const exp
+    = (int) (bits >> Traits::MANTISSA_BITS & Traits::EXPONENT_MASK)
+      - Traits::EXPONENT_BIAS;
+  if (exp < 0)
+    return std::numeric_limits<int>::max();
+  if (exp >= Traits::MANTISSA_BITS)
+    // An integer.
+    return 0;
+
+  // |val| >= 2^exp >= 10^digits, so the value has more than 'digits' digits
+  // left of the decimal point, leaving fewer than MAX_DIGITS - digits to the
+  // right.  1233 / 4096 is just less than log10(2), so 'digits' may be one
+  // short; correct it where pow10() is exact.
+  int digits = exp * 1233 >> 12;
+  if (digits < 19 && std::abs(val) >= pow10(digits + 1))
+    ++digits;
+  return Traits::MAX_DIGITS - 1 - digits;
+}
+
+
+/*
+ * Returns the precision needed to show finite `val` and the values before it,
+ * given that `precision` digits were needed for the values before it.
+ * `scale` is `pow10(precision)`.
+ *
+ * The precision of a value is the number of fractional digits in its shortest
+ * round-trip representation, up to `max_precision`.  Computing that is
+ * expensive, so it is skipped when cheaper tests show the value needs no more
+ * than `precision` digits.
+ *
+ * A value passes if it's an integer when scaled, even if its precision is
+ * greater.  Sets `certain` to false if it may have passed that way.
+ */
+template<typename TYPE>
+inline int
+update_precision(
+  TYPE const val,
+  int const precision,
+  TYPE const scale,
+  int const max_precision,
+  bool& certain)
+{
+  using Traits = FloatTraits<TYPE>;
+
+  certain = true;
+  if (precision == max_precision)
+    // At max precision; no need to check further.
+    return precision;
+
+  // Does a decimal with 'precision' fractional digits, 'num' / 10^precision,
+  // round to the value?  If the numerator and power of ten are exact, the
+  // division rounds correctly, so this is an exact test.
+  double constexpr exact = 1l << (Traits::MANTISSA_BITS + 1);
+  auto const is_decimal = [&](double const num) {
+    return
+      precision <= Traits::MAX_EXACT_POW10
+      && std::abs(num) < exact
+      && (TYPE) num / scale == val;
+  };
+
+  // A naive check: is the value an integer when scaled?
+  double const scaled = val * scale;
+  if (long(scaled) == scaled) {
+    // Unscaled, the value is an integer and certainly needs no precision.
+    certain
+      = precision == 0 || is_decimal(scaled)
+        || get_max_precision(val) <= precision;
+    return precision;
+  }
+  if (get_max_precision(val) <= precision
+      || (std::abs(scaled) < exact
+          && is_decimal((double) long(scaled + std::copysign(0.5, scaled)))))
+    return precision;
+
+  // Might need more precision.  We need to do full-blown formatting.
+  return std::max(precision, std::min(get_precision(val), max_precision));
+}
+
+
+/*
+ * Scans values [begin, end) for NaN, infinities, count, min, and max, into
+ * `result`.  `get(i)` returns value `i`.
+ */
+template<typename TYPE, typename GET>
+inline void
+scan_values(
+  GET const& get,
+  long const begin,
+  long const end,
+  FloatAnalysis<TYPE>& result)
+{
+  for (long i = begin; i < end; ++i) {
+    TYPE const val = get(i);
+    if (std::isnan(val))
+      result.has_nan = true;
+    else if (std::isinf(val))
+      (val > 0 ? result.has_pos_inf : result.has_neg_inf) = true;
+    else {
+      ++result.num;
+      if (val < result.min)
+        result.min = val;
+      if (val > result.max)
+        result.max = val;
+    }
+  }
+}
+
+
+#ifdef __SSE2__
+
+template<typename TYPE> struct Sse;
+
+template<>
+struct Sse<double>
+{
+  using Vec = __m128d;
+  static int constexpr WIDTH = 2;
+  static Vec load(double const* const p) { return _mm_loadu_pd(p); }
+  static Vec set1(double const x) { return _mm_set1_pd(x); }
+  static Vec sub(Vec const a, Vec const b) { return _mm_sub_pd(a, b); }
+  static Vec unord(Vec const a, Vec const b) { return _mm_cmpunord_pd(a, b); }
+  static Vec min(Vec const a, Vec const b) { return _mm_min_pd(a, b); }
+  static Vec max(Vec const a, Vec const b) { return _mm_max_pd(a, b); }
+  static int mask(Vec const a) { return _mm_movemask_pd(a); }
+  static void store(double* const p, Vec const a) { _mm_storeu_pd(p, a); }
+  // Lanes of 'a' where 'm' is set, else of 'b'.
+  static Vec select(Vec const m, Vec const a, Vec const b)
+    { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+};
+
+template<>
+struct Sse<float>
+{
+  using Vec = __m128;
+  static int constexpr WIDTH = 4;
+  static Vec load(float const* const p) { return _mm_loadu_ps(p); }
+  static Vec set1(float const x) { return _mm_set1_ps(x); }
+  static Vec sub(Vec const a, Vec const b) { return _mm_sub_ps(a, b); }
+  static Vec unord(Vec const a, Vec const b) { return _mm_cmpunord_ps(a, b); }
+  static Vec min(Vec const a, Vec const b) { return _mm_min_ps(a, b); }
+  static Vec max(Vec const a, Vec const b) { return _mm_max_ps(a, b); }
+  static int mask(Vec const a) { return _mm_movemask_ps(a); }
+  static void store(float* const p, Vec const a) { _mm_storeu_ps(p, a); }
+  static Vec select(Vec const m, Vec const a, Vec const b)
+    { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+};
+
+
+/*
+ * Like `scan_values()`, for contiguous values, with SSE2.
+ */
+template<typename TYPE>
+inline void
+scan_contiguous(
+  TYPE const* const values,
+  long const begin,
+  long const end,
+  FloatAnalysis<TYPE>& result)
+{
+  using S = Sse<TYPE>;
+  int constexpr STEP = 2 * S::WIDTH;
+  TYPE const initial_min = result.min;
+  auto const lim = S::set1(std::numeric_limits<TYPE>::max());
+  auto const neg_lim = S::set1(-std::numeric_limits<TYPE>::max());
+
+  // Two sets of accumulators, to overlap the latency of min and max.
+  // 'minpd(a, b)' is 'a < b ? a : b', so NaN never replaces a min or max.
+  auto min0 = S::set1(result.min);
+  auto min1 = min0;
+  auto max0 = S::set1(result.max);
+  auto max1 = max0;
+  long num_bad = 0;
+
+  // Handles NaN and infinities in 'val', which are rare.  Returns the lanes
+  // to use for min and max.
+  auto const bad = [&](typename S::Vec const val, typename S::Vec const is_bad,
+                       typename S::Vec& lo, typename S::Vec& hi) {
+    TYPE vals[S::WIDTH];
+    S::store(vals, val);
+    for (auto const v : vals)
+      if (std::isnan(v))
+        result.has_nan = true;
+      else if (std::isinf(v))
+        (v > 0 ? result.has_pos_inf : result.has_neg_inf) = true;
+    auto const m = S::mask(is_bad);
+    for (int lane = 0; lane < S::WIDTH; ++lane)
+      num_bad += m >> lane & 1;
+    lo = S::select(is_bad, lim, val);
+    hi = S::select(is_bad, neg_lim, val);
+  };
+
+  long i = begin;
+  for (long const vec_end = end - (end - begin) % STEP; i < vec_end;
+       i += STEP) {
+    auto lo0 = S::load(values + i);
+    auto lo1 = S::load(values + i + S::WIDTH);
+    auto hi0 = lo0;
+    auto hi1 = lo1;
+    // 'val - val' is NaN if and only if 'val' is NaN or infinite.
+    auto const bad0 = S::unord(S::sub(lo0, lo0), S::sub(lo0, lo0));
+    auto const bad1 = S::unord(S::sub(lo1, lo1), S::sub(lo1, lo1));
+    if (S::mask(bad0) | S::mask(bad1)) {
+      bad(lo0, bad0, lo0, hi0);
+      bad(lo1, bad1, lo1, hi1);
+    }
+    min0 = S::min(lo0, min0);
+    min1 = S::min(lo1, min1);
+    max0 = S::max(hi0, max0);
+    max1 = S::max(hi1, max1);
+  }
+
+  TYPE mins[S::WIDTH];
+  TYPE maxs[S::WIDTH];
+  S::store(mins, S::min(min1, min0));
+  S::store(maxs, S::max(max1, max0));
+  for (int lane = 0; lane < S::WIDTH; ++lane) {
+    if (mins[lane] < result.min)
+      result.min = mins[lane];
+    if (maxs[lane] > result.max)
+      result.max = maxs[lane];
+  }
+  result.num += i - begin - num_bad;
+
+  // A scan in order keeps the first of equal minimums; the only equal values
+  // that differ are zeros of opposite sign.  The initial max is positive, so
+  // it can't be zero.
+  if (result.min == 0 && initial_min != 0)
+    for (long j = begin; j < i; ++j)
+      if (values[j] == 0) {
+        result.min = values[j];
+        break;
+      }
+
+  scan_values<TYPE>(
+    [values](long const j) { return values[j]; }, i, end, result);
+}
+
+#endif
+
+
+
+/*
+ * The precision needed for one chunk of values, assuming none was needed
+ * before it.
+ */
+struct Trajectory
+{
+  // Indices at which the precision increases, with the new precision.
+  std::vector<std::pair<long, int>> steps;
+  // Bits, relative to the chunk, of values that may need more than the
+  // precision after them.  Others need no more.
+  std::vector<uint64_t> uncertain;
+  // The precision at the end of the chunk.
+  int end = 0;
+};
+
+
+/*
+ * Returns the index of the first set bit at or after `index`, or `limit`.
+ */
+inline long
+find_bit(
+  std::vector<uint64_t> const& bits,
+  long const index,
+  long const limit)
+{
+  long w = index / 64;
+  if (w >= (long) bits.size())
+    return limit;
+  uint64_t word = bits[w] >> index % 64 << index % 64;
+  while (word == 0)
+    if (++w < (long) bits.size())
+      word = bits[w];
+    else
+      return limit;
+  long i = w * 64;
+  for (; (word & 1) == 0; word >>= 1)
+    ++i;
+  return std::min(i, limit);
+}
+
+
+/*
+ * Computes the precision for values [begin, end), assuming none was needed
+ * before them, and records it in `traj`.
+ */
+template<typename TYPE, typename GET>
+inline void
+scan_precision(
+  GET const& get,
+  long const begin,
+  long const end,
+  int const max_precision,
+  Trajectory& traj)
+{
+  int precision = 0;
+  TYPE scale = 1;
+  traj.uncertain.assign((end - begin + 63) / 64, 0);
+  for (long i = begin; i < end && precision < max_precision; ++i) {
+    TYPE const val = get(i);
+    if (!std::isfinite(val))
+      continue;
+    bool certain;
+    int const prec
+      = update_precision(val, precision, scale, max_precision, certain);
+    if (!certain)
+      traj.uncertain[(i - begin) / 64] |= 1ull << (i - begin) % 64;
+    if (prec != precision) {
+      precision = prec;
+      scale = pow10(precision);
+      traj.steps.emplace_back(i, precision);
+    }
+  }
+  traj.end = precision;
+}
+
+
+/*
+ * Computes the precision for values [begin, end), given that `precision` was
+ * needed before them.  `traj` is their trajectory from no precision.
+ *
+ * Where the trajectory's precision is less, the values it's certain of need
+ * no more than `precision`, so only the others are checked.  Once the
+ * precision matches the trajectory's, they finish the same.
+ */
+template<typename TYPE, typename GET>
+inline int
+resolve_precision(
+  GET const& get,
+  long const begin,
+  long const end,
+  int precision,
+  int const max_precision,
+  Trajectory const& traj)
+{
+  TYPE scale = pow10(precision);
+  size_t step = 0;
+  // The trajectory's precision before value 'i'.
+  int traj_precision = 0;
+  for (long i = begin; i < end; ++i) {
+    if (precision == traj_precision)
+      return traj.end;
+    if (precision == max_precision)
+      return precision;
+    if (traj_precision < precision) {
+      // Skip to the next value that's uncertain or steps the trajectory.
+      i = std::min(
+        step < traj.steps.size() ? traj.steps[step].first : end,
+        begin + find_bit(traj.uncertain, i - begin, end - begin));
+      if (i == end)
+        break;
+    }
+
+    TYPE const val = get(i);
+    if (std::isfinite(val)) {
+      bool certain;
+      int const prec
+        = update_precision(val, precision, scale, max_precision, certain);
+      if (prec != precision) {
+        precision = prec;
+        scale = pow10(precision);
+      }
+    }
+    if (step < traj.steps.size() && traj.steps[step].first == i)
+      traj_precision = traj.steps[step++].second;
+  }
+  return precision;
+}
+
+
+/*
+ * Scans contiguous values of the analyzed type with SIMD, if available.
+ * Returns false if not.
+ */
+template<typename TYPE>
+inline bool
+scan_direct(
+  TYPE const* const values,
+  long const begin,
+  long const end,
+  FloatAnalysis<TYPE>& result)
+{
+#ifdef __SSE2__
+  scan_contiguous(values, begin, end, result);
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+template<typename VALUE, typename TYPE>
+inline bool
+scan_direct(
+  VALUE const* const,
+  long const,
+  long const,
+  FloatAnalysis<TYPE>&)
+{
+  return false;
+}
+
+
+inline size_t
+text_length(
+  char const* const begin,
+  char const* const end)
+{
+  return string_length(begin, end);
+}
+
+
+inline size_t
+text_length(
+  char32_t const* const begin,
+  char32_t const* const end)
+{
+  return code_point_length(begin, end);
+}
+
+
+}  // namespace analyze
+
+//------------------------------------------------------------------------------
+
+/*
+ * A half-open range of indices to analyze.
+ */
+using Range = std::pair<long, long>;
+
+/*
+ * Analyzes values of floating point `TYPE`, `stride` bytes apart, at the
+ * indices in `ranges`, for choosing a formatter.  Computes precision up to
+ * `max_precision`.
+ *
+ * If `scale` is positive, analyzes the values divided by it, as a formatter
+ * with that scale shows them, without modifying or copying them.  `VALUE` may
+ * then be any arithmetic type; integers are analyzed as doubles.
+ *
+ * Long ranges are analyzed in chunks on up to `num_threads` threads, or one per
+ * core if zero.  The result is the same as scanning the ranges in order.
+ */
+template<
+  typename VALUE,
+  typename TYPE=typename std::conditional<
+    std::is_floating_point<VALUE>::value, VALUE, double>::type>
+inline FloatAnalysis<TYPE>
+analyze_float(
+  VALUE const* const values,
+  long const stride,
+  std::vector<Range> const& ranges,
+  int const max_precision,
+  int num_threads=0,
+  double const scale=0)
+{
+  // Values per chunk, enough to amortize the threading.
+  static long constexpr CHUNK = 1 << 16;
+
+  bool const contiguous = stride == sizeof(VALUE);
+  // Whether the values can be scanned directly, without conversion.
+  bool const direct
+    = contiguous && !(scale > 0) && std::is_same<VALUE, TYPE>::value;
+
+  // Calls 'fn' with a function that gets value 'i'.
+  auto const with_get = [&](auto const& fn) {
+    auto const get_value = [values, stride](long const i) {
+      return load<VALUE>(reinterpret_cast<char const*>(values) + i * stride);
+    };
+    if (scale > 0)
+      // Divide as the formatter does, in double.
+      fn([get_value, scale](long const i) {
+        return TYPE(get_value(i) / scale);
+      });
+    else if (contiguous)
+      fn([values](long const i) { return TYPE(values[i]); });
+    else
+      fn([get_value](long const i) { return TYPE(get_value(i)); });
+  };
+
+  std::vector<Range> chunks;
+  for (auto const& range : ranges)
+    for (long begin = range.first; begin < range.second; begin += CHUNK)
+      chunks.emplace_back(begin, std::min(range.second, begin + CHUNK));
+  if (chunks.empty())
+    chunks.emplace_back(0, 0);
+  long const num_chunks = chunks.size();
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<FloatAnalysis<TYPE>> results(num_chunks);
+  std::vector<analyze::Trajectory> trajs(num_chunks);
+
+  // Scan each chunk independently, computing precision as if none were needed
+  // before it.
+  with_get([&](auto const& get) {
+    run_parallel(num_chunks, num_threads, [&](long const c) {
+      long const begin = chunks[c].first;
+      long const end = chunks[c].second;
+      if (!(direct && analyze::scan_direct(values, begin, end, results[c])))
+        analyze::scan_values<TYPE>(get, begin, end, results[c]);
+      analyze::scan_precision<TYPE>(get, begin, end, max_precision, trajs[c]);
+    });
+  });
+
+  // Merge the chunks in order.  Each chunk's precision is resolved from the
+  // precision needed before it, which is usually quick.
+  FloatAnalysis<TYPE> result = results[0];
+  result.precision = trajs[0].end;
+  for (long c = 1; c < num_chunks; ++c) {
+    auto const& r = results[c];
+    result.has_nan |= r.has_nan;
+    result.has_pos_inf |= r.has_pos_inf;
+    result.has_neg_inf |= r.has_neg_inf;
+    result.num += r.num;
+    // Keep the first of equal values, as a scan in order would.
+    if (r.min < result.min)
+      result.min = r.min;
+    if (r.max > result.max)
+      result.max = r.max;
+    with_get([&](auto const& get) {
+      result.precision = analyze::resolve_precision<TYPE>(
+        get, chunks[c].first, chunks[c].second, result.precision,
+        max_precision, trajs[c]);
+    });
+  }
+  return result;
+}
+
+
+/*
+ * Analyzes all `length` values; see above.
+ */
+template<
+  typename VALUE,
+  typename TYPE=typename std::conditional<
+    std::is_floating_point<VALUE>::value, VALUE, double>::type>
+inline FloatAnalysis<TYPE>
+analyze_float(
+  VALUE const* const values,
+  long const length,
+  long const stride,
+  int const max_precision,
+  int const num_threads=0,
+  double const scale=0)
+{
+  return analyze_float<VALUE, TYPE>(
+    values, stride, {Range{0, length}}, max_precision, num_threads, scale);
+}
+
+
+/*
+ * Analyzes integer values of `TYPE`, `stride` bytes apart, at the indices in
+ * `ranges`, for choosing a formatter, in a single pass.
+ */
+template<typename TYPE>
+inline IntAnalysis<TYPE>
+analyze_int(
+  TYPE const* const values,
+  long const stride,
+  std::vector<Range> const& ranges)
+{
+  static_assert(std::is_integral<TYPE>::value, "not an integer type");
+  using UTYPE = typename std::make_unsigned<TYPE>::type;
+
+  IntAnalysis<TYPE> result;
+  // Branch-free, so that the loop vectorizes for contiguous values.
+  auto const scan = [&](auto const& get, long const begin, long const end) {
+    TYPE min = result.min;
+    TYPE max = result.max;
+    for (long i = begin; i < end; ++i) {
+      TYPE const val = get(i);
+      min = val < min ? val : min;
+      max = val > max ? val : max;
+    }
+    result.min = min;
+    result.max = max;
+  };
+  for (auto const& range : ranges) {
+    if (stride == sizeof(TYPE))
+      scan([values](long const i) { return values[i]; },
+           range.first, range.second);
+    else
+      scan([values, stride](long const i) {
+        return load<TYPE>(reinterpret_cast<char const*>(values) + i * stride);
+      }, range.first, range.second);
+    result.num += std::max(0l, range.second - range.first);
+  }
+
+  if (result.num > 0) {
+    // Negate in unsigned, so that the most negative value doesn't overflow.
+    UTYPE const neg = result.min < 0 ? UTYPE(0) - UTYPE(result.min) : 0;
+    UTYPE const pos = result.max > 0 ? UTYPE(result.max) : 0;
+    result.digits = analyze::num_digits(std::max(neg, pos));
+  }
+  return result;
+}
+
+
+/*
+ * Analyzes all `length` integer values; see above.
+ */
+template<typename TYPE>
+inline IntAnalysis<TYPE>
+analyze_int(
+  TYPE const* const values,
+  long const length,
+  long const stride)
+{
+  return analyze_int(values, stride, {Range{0, length}});
+}
+
+
+/*
+ * Returns the greatest length, in code points, of fixed-width strings, `stride`
+ * bytes apart, at the indices in `ranges`, or `max_size` if any is that long.
+ * Each string is `width` UTF-8 bytes, if `CHAR` is `char`, or UCS-4 code
+ * points, if `char32_t`, padded with trailing NULs.  Skips escape sequences.
+ */
+template<typename CHAR>
+inline size_t
+analyze_strings(
+  CHAR const* const values,
+  long const stride,
+  std::vector<Range> const& ranges,
+  long const width,
+  size_t const max_size)
+{
+  // Wider characters are copied out, since strided strings needn't be aligned.
+  std::vector<CHAR> chars(sizeof(CHAR) > 1 ? width : 0);
+  size_t result = 0;
+  for (auto const& range : ranges)
+    for (long i = range.first; i < range.second && result < max_size; ++i) {
+      auto const ptr = reinterpret_cast<char const*>(values) + i * stride;
+      auto begin = reinterpret_cast<CHAR const*>(ptr);
+      if (!chars.empty()) {
+        memcpy(chars.data(), ptr, width * sizeof(CHAR));
+        begin = chars.data();
+      }
+      auto end = begin + width;
+      while (end != begin && end[-1] == 0)
+        --end;
+      // A string has no more code points than characters.
+      if (size_t(end - begin) > result)
+        result = std::max(result, analyze::text_length(begin, end));
+    }
+  return std::min(result, max_size);
+}
+
+
+/*
+ * Returns the greatest length of all `length` strings; see above.
+ */
+template<typename CHAR>
+inline size_t
+analyze_strings(
+  CHAR const* const values,
+  long const length,
+  long const stride,
+  long const width,
+  size_t const max_size)
+{
+  return analyze_strings(values, stride, {Range{0, length}}, width, max_size);
+}
+
+
+/*
+ * Returns the greatest length, in code points, of UTF-8 strings stored end to
+ * end in `data`, at the indices in `ranges`, or `max_size` if any is that long.
+ * String `i` spans bytes `offsets[i]` up to `offsets[i + 1]`.  Skips escape
+ * sequences.
+ */
+template<typename OFFSET>
+inline size_t
+analyze_strings(
+  OFFSET const* const offsets,
+  char const* const data,
+  std::vector<Range> const& ranges,
+  size_t const max_size)
+{
+  size_t result = 0;
+  for (auto const& range : ranges)
+    for (long i = range.first; i < range.second && result < max_size; ++i) {
+      auto const begin = data + offsets[i];
+      auto const end = data + offsets[i + 1];
+      // A string has no more code points than bytes.
+      if (size_t(end - begin) > result)
+        result = std::max(result, analyze::text_length(begin, end));
+    }
+  return std::min(result, max_size);
+}
+
+//------------------------------------------------------------------------------
+
+/*
+ * Properties of number values, accumulated from any number of arrays, for
+ * choosing a formatter.  Arrays or parts of them may be analyzed separately,
+ * in any order, and the stats merged.
+ *
+ * Each analysis's precision is as for analyze_float(); the merged precision is
+ * their maximum.
+ */
+struct NumberStats
+{
+  bool has_nan = false;
+  bool has_pos_inf = false;
+  bool has_neg_inf = false;
+  // Number of values that are neither NaN nor infinite.
+  long num = 0;
+  // Min and max, excluding NaN and infinity.
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  // Fractional digits needed to show the values exactly, up to a maximum.
+  int precision = 0;
+  // Whether all values were analyzed as integers.
+  bool integer = true;
+  // For integers, digits in the value of largest magnitude, at least one.
+  int digits = 1;
+  // While 'integer', the exact min and max of signed and of unsigned values,
+  // which 'min' and 'max' may round for 64-bit integers.
+  long int_min = std::numeric_limits<long>::max();
+  long int_max = std::numeric_limits<long>::min();
+  unsigned long uint_min = std::numeric_limits<unsigned long>::max();
+  unsigned long uint_max = 0;
+
+  template<typename TYPE>
+  void
+  update(
+    FloatAnalysis<TYPE> const& analysis)
+  {
+    has_nan |= analysis.has_nan;
+    has_pos_inf |= analysis.has_pos_inf;
+    has_neg_inf |= analysis.has_neg_inf;
+    if (analysis.num > 0) {
+      num += analysis.num;
+      min = std::min(min, double(analysis.min));
+      max = std::max(max, double(analysis.max));
+    }
+    precision = std::max(precision, analysis.precision);
+    integer = false;
+  }
+
+  template<typename TYPE>
+  void
+  update(
+    IntAnalysis<TYPE> const& analysis)
+  {
+    if (analysis.num > 0) {
+      num += analysis.num;
+      min = std::min(min, double(analysis.min));
+      max = std::max(max, double(analysis.max));
+      digits = std::max(digits, analysis.digits);
+      if (std::is_signed<TYPE>::value) {
+        int_min = std::min(int_min, (long) analysis.min);
+        int_max = std::max(int_max, (long) analysis.max);
+      }
+      else {
+        uint_min = std::min(uint_min, (unsigned long) analysis.min);
+        uint_max = std::max(uint_max, (unsigned long) analysis.max);
+      }
+    }
+  }
+
+  void
+  merge(
+    NumberStats const& other)
+  {
+    has_nan |= other.has_nan;
+    has_pos_inf |= other.has_pos_inf;
+    has_neg_inf |= other.has_neg_inf;
+    num += other.num;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    precision = std::max(precision, other.precision);
+    integer &= other.integer;
+    digits = std::max(digits, other.digits);
+    int_min = std::min(int_min, other.int_min);
+    int_max = std::max(int_max, other.int_max);
+    uint_min = std::min(uint_min, other.uint_min);
+    uint_max = std::max(uint_max, other.uint_max);
+  }
+
+};
+
+
+/*
+ * Properties of strings, accumulated from any number of arrays, for choosing a
+ * formatter.  Arrays may be analyzed separately and the stats merged.
+ */
+struct StringStats
+{
+  // Number of strings analyzed.
+  long num = 0;
+  // Greatest length in code points, up to the maximum size analyzed.
+  size_t size = 0;
+
+  void
+  update(
+    long const num_strings,
+    size_t const max_length)
+  {
+    num += num_strings;
+    size = std::max(size, max_length);
+  }
+
+  void
+  merge(
+    StringStats const& other)
+  {
+    update(other.num, other.size);
+  }
+
+};
+
+
+namespace analyze {
+
+template<typename TYPE>
+inline void
+analyze_number(
+  NumberStats& stats,
+  TYPE const* const values,
+  long const stride,
+  std::vector<Range> const& ranges,
+  int const max_precision,
+  int const num_threads,
+  double const scale,
+  std::false_type /* is_integral */)
+{
+  stats.update(analyze_float(
+    values, stride, ranges, max_precision, num_threads, scale));
+}
+
+
+template<typename TYPE>
+inline void
+analyze_number(
+  NumberStats& stats,
+  TYPE const* const values,
+  long const stride,
+  std::vector<Range> const& ranges,
+  int const max_precision,
+  int const num_threads,
+  double const scale,
+  std::true_type /* is_integral */)
+{
+  if (scale > 0)
+    // Scaled integers aren't integers.
+    stats.update(analyze_float(
+      values, stride, ranges, max_precision, num_threads, scale));
+  else
+    stats.update(analyze_int(values, stride, ranges));
+}
+
+
+}  // namespace analyze
+
+/*
+ * Analyzes number values of `TYPE`, `stride` bytes apart, at the indices in
+ * `ranges`, into `stats`.  Integers are analyzed as such, unless scaled; see
+ * analyze_float() and analyze_int().
+ */
+template<typename TYPE>
+inline void
+analyze_number(
+  NumberStats& stats,
+  TYPE const* const values,
+  long const stride,
+  std::vector<Range> const& ranges,
+  int const max_precision,
+  int const num_threads=0,
+  double const scale=0)
+{
+  analyze::analyze_number(
+    stats, values, stride, ranges, max_precision, num_threads, scale,
+    std::is_integral<TYPE>());
+}
+
+//------------------------------------------------------------------------------
+
+}  // namespace fixfmt
+
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "fixfmt/bool.hh"
+#include "fixfmt/number.hh"
+#include "fixfmt/string.hh"
+#include "fixfmt/table.hh"
+#include "fixfmt/time.hh"
+
+//------------------------------------------------------------------------------
+// Arrow C data interface
+//------------------------------------------------------------------------------
+// These declarations are the stable ABI of the Arrow C data interface; see
+// https://arrow.apache.org/docs/format/CDataInterface.html.  They're guarded
+// so that they may coexist with other copies.
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+}  // extern "C"
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+//------------------------------------------------------------------------------
+
+namespace fixfmt {
+
+namespace arrow {
+
+/*
+ * Returns the tick scale for an Arrow timestamp ("ts") or duration ("tD")
+ * format string, or 0 if it is neither.
+ */
+inline long
+get_tick_scale(
+  char const* const format,
+  char const* const prefix)
+{
+  auto const len = strlen(prefix);
+  if (strncmp(format, prefix, len) != 0)
+    return 0;
+  switch (format[len]) {
+  case 's': return TickTime::SCALE_SEC;
+  case 'm': return TickTime::SCALE_MSEC;
+  case 'u': return TickTime::SCALE_USEC;
+  case 'n': return TickTime::SCALE_NSEC;
+  default:  return 0;
+  }
+}
+
+
+/*
+ * Returns buffer `index` of `array`.  The array's offset is not applied.
+ */
+template<typename TYPE>
+inline TYPE const*
+get_buffer(
+  ArrowArray const& array,
+  int const index)
+{
+  if (array.n_buffers <= index || array.buffers[index] == nullptr)
+    throw std::invalid_argument("missing Arrow buffer");
+  return static_cast<TYPE const*>(array.buffers[index]);
+}
+
+
+inline void
+check_format(
+  char const* const format,
+  bool const ok)
+{
+  if (!ok)
+    throw std::invalid_argument(
+      string("wrong formatter for Arrow format: ") + format);
+}
+
+
+/*
+ * Adds a column of non-dictionary values, without validity.
+ */
+inline void
+add_values(
+  Table& table,
+  ArrowSchema const& schema,
+  ArrowArray const& array,
+  Number const& format)
+{
+  auto const add = [&](auto const* const values) {
+    table.add_column(values + array.offset, array.length, format);
+  };
+
+  auto const fmt = schema.format;
+  check_format(fmt, fmt[0] != 0 && fmt[1] == 0);
+  switch (fmt[0]) {
+  case 'c': add(get_buffer<signed char>(array, 1)); break;
+  case 'C': add(get_buffer<unsigned char>(array, 1)); break;
+  case 's': add(get_buffer<short>(array, 1)); break;
+  case 'S': add(get_buffer<unsigned short>(array, 1)); break;
+  case 'i': add(get_buffer<int>(array, 1)); break;
+  case 'I': add(get_buffer<unsigned int>(array, 1)); break;
+  case 'l': add(get_buffer<long>(array, 1)); break;
+  case 'L': add(get_buffer<unsigned long>(array, 1)); break;
+  case 'f': add(get_buffer<float>(array, 1)); break;
+  case 'g': add(get_buffer<double>(array, 1)); break;
+  default: check_format(fmt, false);
+  }
+}
+
+
+inline void
+add_values(
+  Table& table,
+  ArrowSchema const& schema,
+  ArrowArray const& array,
+  Bool const& format)
+{
+  check_format(schema.format, strcmp(schema.format, "b") == 0);
+  // Bit-packed; the offset is in bits.
+  table.add_bool_bits(
+    get_buffer<uint8_t>(array, 1), array.offset, array.length, format);
+}
+
+
+inline void
+add_values(
+  Table& table,
+  ArrowSchema const& schema,
+  ArrowArray const& array,
+  String const& format)
+{
+  auto const fmt = schema.format;
+  // The offset applies to the string offsets, not the string data.
+  if (strcmp(fmt, "u") == 0)
+    table.add_utf8_offsets(
+      get_buffer<int32_t>(array, 1) + array.offset, get_buffer<char>(array, 2),
+      array.length, format);
+  else if (strcmp(fmt, "U") == 0)
+    table.add_utf8_offsets(
+      get_buffer<int64_t>(array, 1) + array.offset, get_buffer<char>(array, 2),
+      array.length, format);
+  else
+    check_format(fmt, false);
+}
+
+
+inline void
+add_values(
+  Table& table,
+  ArrowSchema const& schema,
+  ArrowArray const& array,
+  TickTime const& format)
+{
+  // The timestamp's time zone, if any, is ignored; values are UTC.
+  auto const scale = get_tick_scale(schema.format, "ts");
+  check_format(schema.format, scale != 0);
+  if (scale != format.get_scale())
+    throw std::invalid_argument("Arrow timestamp unit doesn't match scale");
+  table.add_column(
+    get_buffer<long>(array, 1) + array.offset, array.length, format);
+}
+
+
+inline void
+add_values(
+  Table& table,
+  ArrowSchema const& schema,
+  ArrowArray const& array,
+  TickDuration const& format)
+{
+  auto const scale = get_tick_scale(schema.format, "tD");
+  check_format(schema.format, scale != 0);
+  if (scale != format.get_scale())
+    throw std::invalid_argument("Arrow duration unit doesn't match scale");
+  table.add_column(
+    get_buffer<long>(array, 1) + array.offset, array.length, format);
+}
+
+
+/*
+ * Adds a column of dictionary indices into `categories`, without validity.
+ */
+inline void
+add_indices(
+  Table& table,
+  ArrowSchema const& schema,
+  ArrowArray const& array,
+  Table const& categories)
+{
+  auto const fmt = schema.format;
+  if (fmt[0] == 0 || fmt[1] != 0)
+    throw std::invalid_argument(
+      string("invalid Arrow dictionary index format: ") + fmt);
+
+  unique_ptr<Column> col;
+  switch (fmt[0]) {
+  case 'c':
+    col = std::make_unique<IndexedColumn<signed char>>(
+      get_buffer<signed char>(array, 1) + array.offset, array.length,
+      categories);
+    break;
+  case 'C':
+    col = std::make_unique<IndexedColumn<unsigned char>>(
+      get_buffer<unsigned char>(array, 1) + array.offset, array.length,
+      categories);
+    break;
+  case 's':
+    col = std::make_unique<IndexedColumn<short>>(
+      get_buffer<short>(array, 1) + array.offset, array.length,
+      categories);
+    break;
+  case 'S':
+    col = std::make_unique<IndexedColumn<unsigned short>>(
+      get_buffer<unsigned short>(array, 1) + array.offset, array.length,
+      categories);
+    break;
+  case 'i':
+    col = std::make_unique<IndexedColumn<int>>(
+      get_buffer<int>(array, 1) + array.offset, array.length,
+      categories);
+    break;
+  case 'I':
+    col = std::make_unique<IndexedColumn<unsigned int>>(
+      get_buffer<unsigned int>(array, 1) + array.offset, array.length,
+      categories);
+    break;
+  case 'l':
+    col = std::make_unique<IndexedColumn<long>>(
+      get_buffer<long>(array, 1) + array.offset, array.length,
+      categories);
+    break;
+  case 'L':
+    col = std::make_unique<IndexedColumn<unsigned long>>(
+      get_buffer<unsigned long>(array, 1) + array.offset, array.length,
+      categories);
+    break;
+  default:
+    throw std::invalid_argument(
+      string("invalid Arrow dictionary index format: ") + fmt);
+  }
+  table.add_column(std::move(col));
+}
+
+
+}  // namespace arrow
+
+//------------------------------------------------------------------------------
+
+/*
+ * Adds a column to `table` over the buffers of an Arrow array, without copying
+ * them.  The buffers must outlive the table.
+ *
+ * `format` must suit the array's type: `Number` for integer and floating
+ * point types, `Bool` for booleans, `String` for UTF-8 and large UTF-8 strings,
+ * and `TickTime` or `TickDuration` for timestamps and durations, with the
+ * array's unit as the scale.  For a dictionary array, `format` must suit the
+ * dictionary's values, which are formatted once each.  Null entries are shown
+ * as `null`.
+ *
+ * Throws `std::invalid_argument` if the array isn't supported or doesn't suit
+ * `format`.
+ */
+template<typename FMT>
+inline void
+add_arrow_column(
+  Table& table,
+  ArrowSchema const& schema,
+  ArrowArray const& array,
+  FMT const& format,
+  string const& null="")
+{
+  if (schema.release == nullptr || array.release == nullptr)
+    throw std::invalid_argument("released Arrow array");
+
+  if (schema.dictionary != nullptr) {
+    if (array.dictionary == nullptr)
+      throw std::invalid_argument("missing Arrow dictionary");
+    // Format the categories once, into a table of their own.
+    Table categories;
+    add_arrow_column(
+      categories, *schema.dictionary, *array.dictionary, format, null);
+    arrow::add_indices(table, schema, array, categories);
+  }
+  else
+    arrow::add_values(table, schema, array, format);
+
+  if (array.null_count != 0 && array.n_buffers > 0
+      && array.buffers[0] != nullptr)
+    table.set_valid(
+      static_cast<uint8_t const*>(array.buffers[0]), array.offset, null);
+}
+
+
+}  // namespace fixfmt
+
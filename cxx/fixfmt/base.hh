@@ -1,5 +1,37 @@
 #pragma once
 
+#include <cstring>
+#include <type_traits>
+
 template<typename T>
 inline void unused(T const&) {}
 
+namespace fixfmt {
+
+/**
+ * Reads a 'TYPE' at 'ptr', which needn't be aligned, as strided values from
+ * packed records may not be.
+ */
+template<typename TYPE>
+inline std::enable_if_t<std::is_trivially_copyable<TYPE>::value, TYPE>
+load(
+  char const* const ptr)
+{
+  TYPE val;
+  memcpy(&val, ptr, sizeof(TYPE));
+  return val;
+}
+
+/**
+ * Reads a 'TYPE' object, such as a string, at 'ptr', which must be aligned.
+ */
+template<typename TYPE>
+inline std::enable_if_t<!std::is_trivially_copyable<TYPE>::value, TYPE const&>
+load(
+  char const* const ptr)
+{
+  return *reinterpret_cast<TYPE const*>(ptr);
+}
+
+}  // namespace fixfmt
+
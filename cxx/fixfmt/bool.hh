@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <string>
 
 #include "fixfmt/text.hh"
@@ -59,8 +61,25 @@ public:
     { check(args); args_ = std::move(args); set_up(); }
 
   size_t get_width() const noexcept { return args_.size; }
+  size_t get_max_bytes() const noexcept
+    { return std::max(true_.size(), false_.size()); }
+  bool is_fixed_bytes() const noexcept
+    { return true_.size() == false_.size(); }
   string operator()(bool const val) const
     { return val ? true_ : false_; }
+  string const& get_str(bool const val) const noexcept
+    { return val ? true_ : false_; }
+
+  /*
+   * Formats `val` into `buf`, which must have room for `get_max_bytes()`
+   * bytes.  Returns the end of the formatted value.
+   */
+  char* format(bool const val, char* const buf) const
+  {
+    string const& str = val ? true_ : false_;
+    memcpy(buf, str.data(), str.size());
+    return buf + str.size();
+  }
 
 private:
 
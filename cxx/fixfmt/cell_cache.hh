@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+//------------------------------------------------------------------------------
+
+namespace fixfmt {
+
+/*
+ * Counts lookups in a set of cell caches, and how many are still in use.
+ */
+struct CellCacheStats
+{
+  long num_caches = 0;
+  long num_enabled = 0;
+  long hits = 0;
+  long misses = 0;
+};
+
+
+/*
+ * A cache of formatted cells, keyed by the bits of values of up to 64 bits.
+ *
+ * Since the key is the value's bits, values that compare equal but format
+ * differently, such as 0.0 and -0.0, or NaNs with different payloads, are
+ * cached separately.
+ *
+ * The cache is an open-addressing hash table that only grows, up to
+ * `max_entries`.  Lookups may run on any number of threads, concurrently with
+ * an insertion; an insertion while another is in progress is skipped.
+ */
+class CellCache
+{
+public:
+
+  /*
+   * Stops using the cache after a block of at least this many lookups with
+   * more misses than hits, once the cache is full.
+   */
+  static constexpr long MIN_BLOCK = 64;
+
+  CellCache(
+    size_t const max_entries,
+    size_t const max_bytes)
+  : max_entries_(max_entries),
+    max_bytes_(max_bytes)
+  {
+    // At most half full, so that probes are short and always end.
+    while (capacity_ < 2 * max_entries_)
+      capacity_ *= 2;
+    keys_.reset(new uint64_t[capacity_]);
+    sizes_.reset(new size_t[capacity_]);
+    cells_.reset(new char[capacity_ * max_bytes_]);
+    used_.reset(new std::atomic<bool>[capacity_]);
+    for (size_t i = 0; i < capacity_; ++i)
+      used_[i].store(false, std::memory_order_relaxed);
+  }
+
+  CellCache(CellCache const&) = delete;
+  CellCache& operator=(CellCache const&) = delete;
+
+  template<typename TYPE>
+  static uint64_t
+  key_of(
+    TYPE const val)
+  {
+    static_assert(sizeof(TYPE) <= sizeof(uint64_t), "value too large");
+    uint64_t key = 0;
+    memcpy(&key, &val, sizeof(TYPE));
+    return key;
+  }
+
+  bool is_enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  long get_hits() const { return hits_.load(std::memory_order_relaxed); }
+  long get_misses() const { return misses_.load(std::memory_order_relaxed); }
+
+  /*
+   * Returns the cell for `key` and stores its size in `size`, or returns null
+   * if it's not cached.
+   */
+  char const*
+  find(
+    uint64_t const key,
+    size_t& size)
+    const
+  {
+    for (size_t i = slot(key); ; i = (i + 1) & (capacity_ - 1)) {
+      if (!used_[i].load(std::memory_order_acquire))
+        return nullptr;
+      if (keys_[i] == key) {
+        size = sizes_[i];
+        return &cells_[i * max_bytes_];
+      }
+    }
+  }
+
+  /*
+   * Caches `cell` of `size` bytes for `key`, unless the cache is full or
+   * another insertion is in progress.
+   */
+  void
+  insert(
+    uint64_t const key,
+    char const* const cell,
+    size_t const size)
+  {
+    assert(size <= max_bytes_);
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || num_entries_ >= max_entries_)
+      return;
+
+    size_t i = slot(key);
+    for (; used_[i].load(std::memory_order_relaxed);
+         i = (i + 1) & (capacity_ - 1))
+      if (keys_[i] == key)
+        return;
+    keys_[i] = key;
+    sizes_[i] = size;
+    memcpy(&cells_[i * max_bytes_], cell, size);
+    // Publish the entry to lookups.
+    used_[i].store(true, std::memory_order_release);
+    ++num_entries_;
+  }
+
+  /*
+   * Records the outcome of a block of lookups.  Disables the cache if it's
+   * full and the block missed more than it hit.
+   */
+  void
+  record(
+    long const hits,
+    long const misses)
+  {
+    hits_.fetch_add(hits, std::memory_order_relaxed);
+    misses_.fetch_add(misses, std::memory_order_relaxed);
+    if (hits + misses >= MIN_BLOCK && misses > hits) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (num_entries_ >= max_entries_)
+        enabled_.store(false, std::memory_order_relaxed);
+    }
+  }
+
+private:
+
+  size_t
+  slot(
+    uint64_t const key)
+    const
+  {
+    // Fibonacci hashing; the high bits are the best mixed.
+    return (key * 0x9e3779b97f4a7c15ull) >> 32 & (capacity_ - 1);
+  }
+
+  size_t const max_entries_;
+  size_t const max_bytes_;
+  size_t capacity_ = 16;
+
+  std::unique_ptr<uint64_t[]> keys_;
+  std::unique_ptr<size_t[]> sizes_;
+  std::unique_ptr<char[]> cells_;
+  // Whether each slot holds an entry.
+  std::unique_ptr<std::atomic<bool>[]> used_;
+
+  // Serializes insertions.
+  std::mutex mutex_;
+  size_t num_entries_ = 0;
+
+  std::atomic<bool> enabled_{true};
+  std::atomic<long> hits_{0};
+  std::atomic<long> misses_{0};
+
+};
+
+
+//------------------------------------------------------------------------------
+
+}  // namespace fixfmt
+
@@ -1,4 +1,5 @@
 #include <cassert>
+#include <cstring>
 #include <ctime>
 #include <iostream>
 
@@ -30,6 +31,18 @@ TickDate::operator()(
 }
 
 
+char*
+TickDate::format(
+  long const val,
+  char* const buf)
+  const
+{
+  auto const str = (*this)(val);
+  memcpy(buf, str.data(), str.size());
+  return buf + str.size();
+}
+
+
 //------------------------------------------------------------------------------
 
 }  // namespace fixfmt
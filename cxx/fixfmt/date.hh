@@ -25,8 +25,11 @@ public:
   }
 
   size_t    get_width()     const { return 10; }
+  size_t    get_max_bytes() const { return 10; }
+  bool      is_fixed_bytes() const { return true; }
 
   string operator()(long val) const;
+  char* format(long val, char* buf) const;
 
 private:
 
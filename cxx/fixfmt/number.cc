@@ -33,19 +33,43 @@ Number::Scale const Number::SCALE_KIBI          = {1 << 10, "Ki"};
 
 string 
 Number::operator()(
-  long val) 
+  long const val) 
+  const
+{
+  string result(max_bytes_, args_.pad);
+  char* const buf = &result[0];
+  result.resize(format(val, buf) - buf);
+  return result;
+}
+
+
+string 
+Number::operator()(
+  double const val) 
+  const
+{
+  string result(max_bytes_, args_.pad);
+  char* const buf = &result[0];
+  result.resize(format(val, buf) - buf);
+  return result;
+}
+
+
+char*
+Number::format(
+  long val,
+  char* const buf) 
   const
 {
   // Always use the FP code path if there's a scale.
   if (args_.scale.enabled())
-    return (*this)((double) val);
+    return format((double) val, buf);
 
   if (val < 0 && args_.sign == SIGN_NONE)
-    return bad_;
+    return copy(bad_, buf);
 
-  // Format directly into the string's buffer.
-  string result(alloc_size_, args_.pad);
-  char* const buf = &result[0];
+  // Format directly into the buffer.
+  memset(buf, args_.pad, alloc_size_);
 
   int const sign_len = args_.sign == SIGN_NONE ? 0 : 1;
   bool const nonneg = val >= 0;
@@ -61,7 +85,7 @@ Number::operator()(
       buf[sign_len + --i] = '0' + val % 10;
     // We should have rendered the entire value; otherwise we've overflowed.
     if (val != 0)
-      return bad_;
+      return copy(bad_, buf);
   }
 
   // Render the sign.
@@ -77,35 +101,36 @@ Number::operator()(
       memset(point, '0', args_.precision);
   }
 
-  assert(string_length(result) == width_);
-  return result;
+  assert(string_length(string(buf, alloc_size_)) == width_);
+  return buf + alloc_size_;
 }
 
 
-string 
-Number::operator()(
-  double const value) 
+char*
+Number::format(
+  double const value,
+  char* const buf) 
   const
 {
   if (std::isnan(value))
-    return nan_;
+    return copy(nan_, buf);
   else if (value < 0 && args_.sign == SIGN_NONE)
     // With SIGN_NONE, we can't render negative numbers.
-    return bad_;
+    return copy(bad_, buf);
 
   // Apply the scale factor, if any.
   double const val = args_.scale.enabled() ? value / args_.scale.factor : value;
 
   if (std::isinf(val))
     // Return the appropriate infinity.
-    return val >= 0 ? pos_inf_ : neg_inf_;
+    return copy(val >= 0 ? pos_inf_ : neg_inf_, buf);
 
   else {
     int const precision 
       = args_.precision == PRECISION_NONE ? 0 : args_.precision;
 
     // FIXME: Assumes ASCII only.
-    char buf[384];  // Enough room for DBL_MAX.
+    char digits[384];  // Enough room for DBL_MAX.
     bool sign;
     int length;
     int decimal_pos;
@@ -113,18 +138,18 @@ Number::operator()(
       std::abs(val), 
       double_conversion::DoubleToStringConverter::FIXED,
       precision,
-      buf, sizeof(buf),
+      digits, sizeof(digits),
       &sign, &length, &decimal_pos);
     // FIXME: Why are trailing zeros being suppressed?  Can we change this, as
     // we will just add them later?
     // assert(length - decimal_pos == precision);
     assert(length - decimal_pos <= precision);
 
-    string result;
-
     if (decimal_pos > args_.size)
       // Integral part too large.
-      return bad_;
+      return copy(bad_, buf);
+
+    char* pos = buf;
 
     // The number of digits in the integral part.
     //
@@ -137,50 +162,65 @@ Number::operator()(
 
     // Add pad and sign.  Space padding precedes sign, while zero padding
     // follows it.  
-    if (args_.pad == PAD_SPACE && args_.size > int_digits)
+    if (args_.pad == PAD_SPACE && args_.size > int_digits) {
       // Space padding. 
-      result.append(args_.size - int_digits, ' ');
+      memset(pos, ' ', args_.size - int_digits);
+      pos += args_.size - int_digits;
+    }
     if (args_.sign != SIGN_NONE)
       // The sign character.
-      result.push_back(get_sign_char(val >= 0));
-    if (args_.pad == PAD_ZERO && args_.size > int_digits)
+      *pos++ = get_sign_char(val >= 0);
+    if (args_.pad == PAD_ZERO && args_.size > int_digits) {
       // Zero padding.
-      result.append(args_.size - int_digits, '0');
+      memset(pos, '0', args_.size - int_digits);
+      pos += args_.size - int_digits;
+    }
 
     // Add digits for the integral part.
     if (decimal_pos > length) {
       // The integral part needs to be zero-padded.
-      result.append(buf, length);
-      result.append(decimal_pos - length, '0');
+      memcpy(pos, digits, length);
+      pos += length;
+      memset(pos, '0', decimal_pos - length);
+      pos += decimal_pos - length;
       length = decimal_pos;
     }
-    else if (decimal_pos > 0)
-      result.append(buf, decimal_pos);
+    else if (decimal_pos > 0) {
+      memcpy(pos, digits, decimal_pos);
+      pos += decimal_pos;
+    }
     else if (args_.size > 0)
       // Show at least one zero.
-      result.push_back('0');
+      *pos++ = '0';
 
     if (args_.precision != PRECISION_NONE) {
       // Add the decimal point.
-      result.push_back(args_.point);
+      *pos++ = args_.point;
       
       // Pad with zeros after the decimal point if needed.
-      if (decimal_pos < 0)
-        result.append(-decimal_pos, '0');
+      if (decimal_pos < 0) {
+        memset(pos, '0', -decimal_pos);
+        pos += -decimal_pos;
+      }
       // Add fractional digits.
-      if (length - decimal_pos > 0)
-        result.append(&buf[std::max(decimal_pos, 0)]);
+      if (length - decimal_pos > 0) {
+        int const start = std::max(decimal_pos, 0);
+        memcpy(pos, &digits[start], length - start);
+        pos += length - start;
+      }
       // Pad with zeros at the end, if necessary.
-      if (length - decimal_pos < args_.precision)
-        result.append(args_.precision - (length - decimal_pos), '0');
+      if (length - decimal_pos < args_.precision) {
+        memset(pos, '0', args_.precision - (length - decimal_pos));
+        pos += args_.precision - (length - decimal_pos);
+      }
     }
  
     if (args_.scale.enabled()) 
       // Tack on the scale suffix.
-      result.append(args_.scale.suffix);
+      pos = copy(args_.scale.suffix, pos);
 
-    assert(string_length(result) == width_);
-    return result;
+    assert(string_length(string(buf, pos)) == width_);
+    return pos;
   }
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <ostream>
@@ -118,21 +119,48 @@ public:
     { check(args); args_ = std::move(args); set_up(); }
 
   size_t        get_width() const noexcept { return width_; }
+  size_t        get_max_bytes() const noexcept { return max_bytes_; }
+  bool          is_fixed_bytes() const noexcept 
+    { return min_bytes_ == max_bytes_; }
   string        operator()(long val) const;
   string        operator()(double val) const;
 
+  /*
+   * Formats `val` into `buf`, which must have room for `get_max_bytes()`
+   * bytes.  Returns the end of the formatted value.
+   */
+  char*         format(long val, char* buf) const;
+  char*         format(double val, char* buf) const;
+
   // Make sure we use the integer implementation for integral types.
   string operator()(int            val) const { return operator()((long) val); }
   string operator()(short          val) const { return operator()((long) val); }
   string operator()(char           val) const { return operator()((long) val); }
+  string operator()(signed char    val) const { return operator()((long) val); }
   string operator()(unsigned long  val) const { return operator()((long) val); }
   string operator()(unsigned int   val) const { return operator()((long) val); }
   string operator()(unsigned short val) const { return operator()((long) val); }
   string operator()(unsigned char  val) const { return operator()((long) val); }
+  string operator()(long long val) const { return operator()((long) val); }
+  string operator()(unsigned long long val) const
+    { return operator()((long) val); }
+
+  char* format(int            v, char* b) const { return format((long) v, b); }
+  char* format(short          v, char* b) const { return format((long) v, b); }
+  char* format(char           v, char* b) const { return format((long) v, b); }
+  char* format(signed char    v, char* b) const { return format((long) v, b); }
+  char* format(unsigned long  v, char* b) const { return format((long) v, b); }
+  char* format(unsigned int   v, char* b) const { return format((long) v, b); }
+  char* format(unsigned short v, char* b) const { return format((long) v, b); }
+  char* format(unsigned char  v, char* b) const { return format((long) v, b); }
+  char* format(long long v, char* b) const { return format((long) v, b); }
+  char* format(unsigned long long v, char* b) const
+    { return format((long) v, b); }
 
 private:
 
   static void check(Args const&);
+  static char* copy(string const& str, char* buf);
   char get_sign_char(bool nonneg) const;
   string format_inf_nan(string const& str, int sign) const;
   void set_up();
@@ -143,6 +171,10 @@ private:
   size_t    width_;
   // Maximum allocation size.
   size_t    alloc_size_;
+  // Minimum and maximum number of bytes in any formatted value, including NaN
+  // and inf.
+  size_t    min_bytes_;
+  size_t    max_bytes_;
 
   string    nan_;
   string    pos_inf_;
@@ -171,6 +203,16 @@ Number::check(
 }
 
 
+inline char*
+Number::copy(
+  string const& str,
+  char* const buf)
+{
+  memcpy(buf, str.data(), str.size());
+  return buf + str.size();
+}
+
+
 inline char 
 Number::get_sign_char(
   bool const nonneg) 
@@ -222,6 +264,11 @@ Number::set_up()
   pos_inf_ = format_inf_nan(args_.inf,  1);
   neg_inf_ = format_inf_nan(args_.inf, -1);
   bad_ = std::string(width_, args_.bad);
+
+  min_bytes_ = std::min({
+    alloc_size_, nan_.size(), pos_inf_.size(), neg_inf_.size(), bad_.size()});
+  max_bytes_ = std::max({
+    alloc_size_, nan_.size(), pos_inf_.size(), neg_inf_.size(), bad_.size()});
 }
 
 
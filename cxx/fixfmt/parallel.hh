@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+namespace fixfmt {
+
+/*
+ * Runs `fn(task)` for each task in [0, num_tasks), on up to `num_threads`
+ * threads including the calling thread.  Returns when all tasks are done.
+ *
+ * Tasks are first divided into contiguous ranges, one per thread.  Each thread
+ * takes tasks from the front of its own range.  A thread whose range is empty
+ * steals the back half of the largest remaining range, so threads stay busy
+ * when some tasks cost much more than others.
+ *
+ * If a task throws, the threads start no further tasks, and the exception is
+ * rethrown in the calling thread once all threads have finished.
+ */
+template<typename FN>
+void
+run_parallel(
+  long const num_tasks,
+  int const num_threads,
+  FN const& fn)
+{
+  long const n = std::max(1l, std::min((long) num_threads, num_tasks));
+  if (n == 1) {
+    for (long task = 0; task < num_tasks; ++task)
+      fn(task);
+    return;
+  }
+
+  // The remaining tasks of one thread.
+  struct Range
+  {
+    std::mutex mutex;
+    long next;
+    long end;
+  };
+
+  std::unique_ptr<Range[]> ranges(new Range[n]);
+  for (long i = 0; i < n; ++i) {
+    ranges[i].next = num_tasks * i / n;
+    ranges[i].end = num_tasks * (i + 1) / n;
+  }
+
+  // Steals half the largest other range into range 'self'.  Returns false if
+  // there's nothing left to steal; a range with a single task left is not
+  // worth splitting.
+  auto const steal = [&](long const self) {
+    long victim = -1;
+    long most = 1;
+    for (long i = 0; i < n; ++i)
+      if (i != self) {
+        std::lock_guard<std::mutex> lock(ranges[i].mutex);
+        if (ranges[i].end - ranges[i].next > most) {
+          victim = i;
+          most = ranges[i].end - ranges[i].next;
+        }
+      }
+    if (victim == -1)
+      return false;
+
+    long begin;
+    long end;
+    {
+      std::lock_guard<std::mutex> lock(ranges[victim].mutex);
+      // The victim may have made progress since we looked.
+      end = ranges[victim].end;
+      begin = end - (end - ranges[victim].next) / 2;
+      if (begin == end)
+        // Too little left to split; look again.
+        return true;
+      ranges[victim].end = begin;
+    }
+    std::lock_guard<std::mutex> lock(ranges[self].mutex);
+    ranges[self].next = begin;
+    ranges[self].end = end;
+    return true;
+  };
+
+  // The exception thrown on each thread, if any.
+  std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[n]);
+  std::atomic<bool> failed{false};
+
+  auto const work = [&](long const self) {
+    try {
+      while (!failed) {
+        long task = -1;
+        {
+          std::lock_guard<std::mutex> lock(ranges[self].mutex);
+          if (ranges[self].next < ranges[self].end)
+            task = ranges[self].next++;
+        }
+        if (task >= 0)
+          fn(task);
+        else if (!steal(self))
+          break;
+      }
+    }
+    catch (...) {
+      errors[self] = std::current_exception();
+      failed = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  try {
+    for (long i = 1; i < n; ++i)
+      threads.emplace_back(work, i);
+  }
+  catch (...) {
+    // Couldn't start a thread.  Stop the ones that did start.
+    errors[0] = std::current_exception();
+    failed = true;
+  }
+  work(0);
+  for (auto& thread : threads)
+    thread.join();
+
+  for (long i = 0; i < n; ++i)
+    if (errors[i])
+      std::rethrow_exception(errors[i]);
+}
+
+
+//------------------------------------------------------------------------------
+
+}  // namespace fixfmt
+
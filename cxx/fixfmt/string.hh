@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <string>
 
 #include "fixfmt/text.hh"
@@ -48,6 +50,21 @@ public:
   size_t        get_width() const noexcept { return args_.size; }
   string        operator()(string const& str) const;
 
+  /*
+   * An upper bound on the number of bytes in a formatted string, assuming
+   * the string contains no escape sequences.
+   */
+  size_t        get_max_bytes() const noexcept { return 4 * args_.size; }
+  bool          is_fixed_bytes() const noexcept { return false; }
+
+  /*
+   * Formats `str` into `buf`, which must have room for `get_max_bytes()`
+   * bytes.  Returns the end of the formatted string.  If escape sequences
+   * make the result longer, doesn't write it, but returns `buf` plus its size
+   * regardless.
+   */
+  char*         format(string const& str, char* buf) const;
+
 private:
 
   static void   check(Args const&);
@@ -77,5 +94,18 @@ String::operator()(
 }
 
 
+inline char*
+String::format(
+  string const& str,
+  char* const buf)
+  const
+{
+  auto const result = (*this)(str);
+  if (result.size() <= get_max_bytes())
+    memcpy(buf, result.data(), result.size());
+  return buf + result.size();
+}
+
+
 }  // namespace fixfmt
 
@@ -1,14 +1,27 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <limits>
 #include <memory>
 #include <numeric>
-#include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "fixfmt/base.hh"
+#include "fixfmt/bool.hh"
+#include "fixfmt/cell_cache.hh"
+#include "fixfmt/number.hh"
+#include "fixfmt/parallel.hh"
+#include "fixfmt/string.hh"
+#include "fixfmt/text.hh"
+#include "fixfmt/time.hh"
+
 //------------------------------------------------------------------------------
 
 namespace fixfmt {
@@ -39,19 +52,79 @@ public:
    */
   virtual string operator()(long index) const = 0;
 
+  /**
+   * Returns an upper bound on the number of bytes in a formatted entry.
+   *
+   * The default assumes UTF-8 text without escape sequences.
+   */
+  virtual size_t get_max_bytes() const { return 4 * get_width(); }
+
+  /**
+   * Formats entry 'index' into 'buf', which must have room for
+   * 'get_max_bytes()' bytes.  Returns the end of the formatted entry.
+   *
+   * An entry with escape sequences may be longer than the bound.  Such an
+   * entry isn't written; this returns 'buf' plus its size regardless, and the
+   * caller must get the entry from 'operator()' instead.
+   */
+  virtual char* 
+  format(
+    long const index, 
+    char* const buf) 
+    const
+  {
+    auto const str = (*this)(index);
+    if (str.size() <= get_max_bytes())
+      memcpy(buf, str.data(), str.size());
+    return buf + str.size();
+  }
+
+  /**
+   * Returns true if every formatted entry is exactly 'get_max_bytes()' bytes.
+   */
+  virtual bool is_fixed_bytes() const { return false; }
+
+  /**
+   * Formats entries 'begin' up to 'end', writing entry 'i' at
+   * 'buf + (i - begin) * stride'.  If 'sizes' is not null, stores the size of
+   * each entry in it.  Like 'format()', doesn't write overlong entries.
+   */
+  virtual void 
+  format_block(
+    long const begin,
+    long const end,
+    char* const buf,
+    size_t const stride,
+    size_t* sizes)
+    const
+  {
+    char* out = buf;
+    for (long i = begin; i < end; ++i, out += stride) {
+      auto const size = format(i, out) - out;
+      if (sizes != nullptr)
+        *sizes++ = size;
+    }
+  }
+
 };
 
 
+/**
+ * A column of 'TYPE' values, formatted with 'FMT'.  Values are 'stride' bytes
+ * apart.
+ */
 template<typename TYPE, typename FMT>
 class ColumnImpl
   : public Column
 {
 public:
 
-  ColumnImpl(TYPE const* values, long length, FMT format)
-  : values_(values),
+  ColumnImpl(
+    TYPE const* values, long length, FMT format, long stride=sizeof(TYPE))
+  : values_(reinterpret_cast<char const*>(values)),
     length_(length),
-    format_(std::move(format))
+    format_(std::move(format)),
+    stride_(stride)
   {
   }
 
@@ -63,16 +136,51 @@ public:
 
   virtual string operator()(long const index) const override
   {
-    return format_(values_[index]);
+    return format_(get(index));
+  }
+
+  virtual size_t get_max_bytes() const override 
+    { return format_.get_max_bytes(); }
+
+  virtual char* format(long const index, char* const buf) const override
+  {
+    return format_.format(get(index), buf);
+  }
+
+  virtual bool is_fixed_bytes() const override 
+    { return format_.is_fixed_bytes(); }
+
+  virtual void 
+  format_block(
+    long const begin,
+    long const end,
+    char* const buf,
+    size_t const stride,
+    size_t* sizes)
+    const override
+  {
+    char* out = buf;
+    if (sizes == nullptr)
+      for (long i = begin; i < end; ++i, out += stride)
+        format_.format(get(i), out);
+    else
+      for (long i = begin; i < end; ++i, out += stride)
+        *sizes++ = format_.format(get(i), out) - out;
   }
 
   FMT const& get_format() const { return format_; }
 
 private:
 
-  TYPE const* const values_;
+  TYPE get(long const index) const
+  {
+    return load<TYPE>(values_ + index * stride_);
+  }
+
+  char const* const values_;
   long const length_;
   FMT const format_;
+  long const stride_;
 
 };
 
@@ -80,9 +188,16 @@ private:
 /**
  * A column with one degree of indirection through an integral index column.
  *
- * For categorical columns.
+ * For categorical columns.  'column' holds the categories.  Each category is
+ * formatted once, on construction, into a dictionary of formatted entries at a
+ * fixed stride; formatting an entry copies it from the dictionary by code.  A
+ * code that isn't a valid category, such as -1 for a missing value, is
+ * formatted as 'missing'.
+ *
+ * Since the categories are pre-formatted, 'column' need not outlive this.
+ * Codes are 'index_stride' bytes apart.
  */
-template<typename IDXTYPE, typename TYPE, typename FMT>
+template<typename IDXTYPE>
 class IndexedColumn
   : public Column
 {
@@ -91,32 +206,326 @@ public:
   IndexedColumn(
     IDXTYPE const* const index, 
     long const index_length, 
-    ColumnImpl<TYPE, FMT> column)
-    : index_(index),
+    Column const& column,
+    string const& missing="",
+    long const index_stride=sizeof(IDXTYPE))
+    : index_(reinterpret_cast<char const*>(index)),
       index_length_(index_length),
-      column_(std::move(column))
+      index_stride_(index_stride),
+      num_categories_(column.get_length()),
+      width_(column.get_width())
   {
+    // Format the categories, followed by the sentinel entry for invalid codes.
+    std::vector<string> entries;
+    entries.reserve(num_categories_ + 1);
+    for (long c = 0; c < num_categories_; ++c)
+      entries.push_back(column(c));
+    entries.push_back(palide(missing, width_, "", " "));
+
+    // Lay out the entries at the longest one's size, which may exceed the
+    // column's bound if a category has escape sequences.
+    stride_ = 0;
+    for (auto const& entry : entries)
+      stride_ = std::max(stride_, entry.size());
+    dict_.resize(entries.size() * stride_);
+    sizes_.resize(entries.size());
+    for (size_t e = 0; e < entries.size(); ++e) {
+      memcpy(&dict_[e * stride_], entries[e].data(), entries[e].size());
+      sizes_[e] = entries[e].size();
+    }
+
+    fixed_bytes_ = std::all_of(
+      sizes_.begin(), sizes_.end(), 
+      [this](size_t const size) { return size == stride_; });
   }
 
   virtual ~IndexedColumn() override {}
 
-  virtual int get_width() const override 
-  { 
-    return column_.get_format().get_width(); 
-  }
+  virtual int get_width() const override { return width_; }
 
   virtual long get_length() const override { return index_length_; }
 
   virtual string operator()(long const index) const override
   {
-    return column_(index_[index]);
+    auto const entry = get_entry(index);
+    return string(&dict_[entry * stride_], sizes_[entry]);
+  }
+
+  virtual size_t get_max_bytes() const override { return stride_; }
+
+  virtual char* format(long const index, char* const buf) const override
+  {
+    auto const entry = get_entry(index);
+    memcpy(buf, &dict_[entry * stride_], sizes_[entry]);
+    return buf + sizes_[entry];
+  }
+
+  virtual bool is_fixed_bytes() const override { return fixed_bytes_; }
+
+  virtual void 
+  format_block(
+    long const begin,
+    long const end,
+    char* const buf,
+    size_t const stride,
+    size_t* sizes)
+    const override
+  {
+    char* out = buf;
+    for (long i = begin; i < end; ++i, out += stride) {
+      auto const entry = get_entry(i);
+      memcpy(out, &dict_[entry * stride_], sizes_[entry]);
+      if (sizes != nullptr)
+        *sizes++ = sizes_[entry];
+    }
   }
 
 private:
 
-  IDXTYPE const* const index_;
+  /**
+   * Returns the dictionary entry for row 'index'.
+   */
+  long
+  get_entry(
+    long const index)
+    const
+  {
+    long const code = load<IDXTYPE>(index_ + index * index_stride_);
+    return 0 <= code && code < num_categories_ ? code : num_categories_;
+  }
+
+  char const* const index_;
   long const index_length_;
-  ColumnImpl<TYPE, FMT> const column_;
+  long const index_stride_;
+  long const num_categories_;
+  int const width_;
+  // Bytes per dictionary entry.
+  size_t stride_;
+  // Formatted categories, followed by the sentinel entry.
+  std::vector<char> dict_;
+  // Size of each formatted entry.
+  std::vector<size_t> sizes_;
+  bool fixed_bytes_;
+
+};
+
+
+/**
+ * A column whose values repeat in runs, such as a sorted key column.
+ *
+ * Formats each run's value once, and copies the formatted cell for the rest of
+ * the run.  Depending on 'repeat', a row that repeats the previous row's value
+ * shows the value, a blank, or a 'ditto' marker.  Whether a row repeats depends
+ * only on the data, so a rendered range may start with a repeat.
+ *
+ * The values are either a plain array, in which runs of bitwise equal values
+ * are detected as they're formatted, or run-length encoded, as one value per
+ * run and the run lengths.
+ */
+template<typename TYPE, typename FMT>
+class RunColumn
+  : public Column
+{
+  static_assert(std::is_arithmetic<TYPE>::value, "values must be arithmetic");
+
+public:
+
+  enum Repeat
+  {
+    REPEAT_SHOW,
+    REPEAT_BLANK,
+    REPEAT_DITTO,
+  };
+
+  /**
+   * A column of 'length' plain values, 'stride' bytes apart.
+   */
+  RunColumn(
+    TYPE const* const values,
+    long const length,
+    FMT format,
+    Repeat const repeat=REPEAT_SHOW,
+    string const& ditto="\"",
+    long const stride=sizeof(TYPE))
+  : values_(reinterpret_cast<char const*>(values)),
+    length_(length),
+    format_(std::move(format)),
+    stride_(stride),
+    repeat_(repeat),
+    marker_(get_marker(repeat, ditto, format_.get_width()))
+  {
+  }
+
+  /**
+   * A column of 'num_runs' runs.  Run 'r' is 'run_lengths[r]' repeats of
+   * 'values[r]'.
+   */
+  RunColumn(
+    TYPE const* const values,
+    long const* const run_lengths,
+    long const num_runs,
+    FMT format,
+    Repeat const repeat=REPEAT_SHOW,
+    string const& ditto="\"",
+    long const stride=sizeof(TYPE))
+  : values_(reinterpret_cast<char const*>(values)),
+    length_(std::accumulate(run_lengths, run_lengths + num_runs, 0l)),
+    format_(std::move(format)),
+    stride_(stride),
+    repeat_(repeat),
+    marker_(get_marker(repeat, ditto, format_.get_width())),
+    run_ends_(num_runs)
+  {
+    std::partial_sum(run_lengths, run_lengths + num_runs, run_ends_.begin());
+  }
+
+  virtual ~RunColumn() override {}
+
+  virtual int get_width() const override { return format_.get_width(); }
+
+  virtual long get_length() const override { return length_; }
+
+  virtual string operator()(long const index) const override
+  {
+    long run;
+    bool const repeat = is_repeat(index, run);
+    return repeat && repeat_ != REPEAT_SHOW ? marker_ : format_(get(run));
+  }
+
+  virtual size_t get_max_bytes() const override
+    { return std::max(format_.get_max_bytes(), marker_.size()); }
+
+  virtual char* format(long const index, char* const buf) const override
+  {
+    long run;
+    bool const repeat = is_repeat(index, run);
+    if (repeat && repeat_ != REPEAT_SHOW)
+      return copy(marker_, buf);
+    else
+      return format_.format(get(run), buf);
+  }
+
+  virtual bool is_fixed_bytes() const override
+  {
+    return
+      format_.is_fixed_bytes()
+      && (repeat_ == REPEAT_SHOW || marker_.size() == format_.get_max_bytes());
+  }
+
+  virtual void
+  format_block(
+    long const begin,
+    long const end,
+    char* const buf,
+    size_t const stride,
+    size_t* sizes)
+    const override
+  {
+    // The formatted value of the current run, once formatted.
+    string cell(format_.get_max_bytes(), '\0');
+    size_t size = 0;
+    bool have_cell = false;
+
+    char* out = buf;
+    long run = -1;
+    for (long i = begin; i < end; ++i, out += stride) {
+      long const prev_run = run;
+      bool const repeat = is_repeat(i, run, prev_run);
+      if (repeat && repeat_ != REPEAT_SHOW) {
+        copy(marker_, out);
+        if (sizes != nullptr)
+          *sizes++ = marker_.size();
+      }
+      else {
+        if (!repeat || !have_cell) {
+          size = format_.format(get(run), &cell[0]) - &cell[0];
+          have_cell = true;
+        }
+        if (size <= cell.size())
+          memcpy(out, cell.data(), size);
+        if (sizes != nullptr)
+          *sizes++ = size;
+      }
+    }
+  }
+
+  FMT const& get_format() const { return format_; }
+
+private:
+
+  static string
+  get_marker(
+    Repeat const repeat,
+    string const& ditto,
+    int const width)
+  {
+    return
+      repeat == REPEAT_SHOW ? ""
+      : palide(
+          repeat == REPEAT_DITTO ? ditto : "", width, "", " ", 1,
+          PAD_POS_CENTER);
+  }
+
+  static char*
+  copy(
+    string const& str,
+    char* const buf)
+  {
+    memcpy(buf, str.data(), str.size());
+    return buf + str.size();
+  }
+
+  TYPE get(long const index) const
+  {
+    return load<TYPE>(values_ + index * stride_);
+  }
+
+  /**
+   * True if row 'index' repeats the previous row's value.  Stores in 'run' the
+   * index of the row's value: its run, for RLE, or the row itself.
+   *
+   * 'prev_run' is the run of the previous row, if known, to avoid a search.
+   */
+  bool
+  is_repeat(
+    long const index,
+    long& run,
+    long const prev_run=-1)
+    const
+  {
+    if (run_ends_.empty()) {
+      run = index;
+      if (index == 0)
+        return false;
+      auto const val = get(index);
+      auto const prev = get(index - 1);
+      return memcmp(&val, &prev, sizeof(TYPE)) == 0;
+    }
+    else {
+      long const num_runs = run_ends_.size();
+      if (prev_run >= 0 && index < run_ends_[prev_run])
+        run = prev_run;
+      else if (
+        prev_run >= 0 && prev_run + 1 < num_runs
+        && index < run_ends_[prev_run + 1])
+        run = prev_run + 1;
+      else
+        // Also skips empty runs.
+        run = std::upper_bound(run_ends_.begin(), run_ends_.end(), index)
+              - run_ends_.begin();
+      return index > (run == 0 ? 0 : run_ends_[run - 1]);
+    }
+  }
+
+  char const* const values_;
+  long const length_;
+  FMT const format_;
+  long const stride_;
+  Repeat const repeat_;
+  // The formatted blank or ditto marker, for repeats.
+  string const marker_;
+  // For RLE, the end row of each run.
+  std::vector<long> run_ends_;
 
 };
 
@@ -138,6 +547,32 @@ public:
   virtual string operator()(long const /* index */) const override
     { return str_; }
 
+  virtual size_t get_max_bytes() const override { return str_.size(); }
+
+  virtual char* format(long const /* index */, char* const buf) const override
+  {
+    memcpy(buf, str_.data(), str_.size());
+    return buf + str_.size();
+  }
+
+  virtual bool is_fixed_bytes() const override { return true; }
+
+  virtual void 
+  format_block(
+    long const begin,
+    long const end,
+    char* const buf,
+    size_t const stride,
+    size_t* sizes)
+    const override
+  {
+    char* out = buf;
+    for (long i = begin; i < end; ++i, out += stride)
+      memcpy(out, str_.data(), str_.size());
+    if (sizes != nullptr)
+      std::fill(sizes, sizes + (end - begin), str_.size());
+  }
+
 private:
 
   string str_;
@@ -147,48 +582,1147 @@ private:
 
 //------------------------------------------------------------------------------
 
+/**
+ * A table of columns and literal strings, rendered row by row.
+ *
+ * The table formats columns of the common kinds -- numbers of each width,
+ * bools, ticks, and fixed-size strings -- directly from their arrays.  Since
+ * these form a closed set, the table dispatches on a column's kind once per
+ * block of rows, instead of with a virtual call per cell.  Literal strings are
+ * stored inline.  Any other 'Column' may be added with 'add_column', and is
+ * called through its virtual interface.
+ */
 class Table
   : public Column
 {
 public:
 
-  Table() : width_(0), length_(MAX_INDEX) {}
+  /**
+   * Number of rows rendered together, one column at a time, by 'render_rows'.
+   */
+  static constexpr long BLOCK_SIZE = 1024;
+
+  /**
+   * A number column longer than a block, with at most this many distinct
+   * values in its first block, caches its formatted cells.
+   */
+  static constexpr size_t CACHE_MAX_SAMPLED = 512;
+  /**
+   * Maximum number of distinct values in a number column's cache.
+   */
+  static constexpr size_t CACHE_MAX_ENTRIES = 2048;
+
+  Table() 
+  : width_(0), 
+    length_(MAX_INDEX), 
+    max_bytes_(0), 
+    fixed_bytes_(true) 
+  {
+  }
+
+  /**
+   * Adds a column of numbers of any of the integral types, 'float', or
+   * 'double'.
+   *
+   * For this and the other column kinds, values are 'stride' bytes apart.
+   */
+  template<typename TYPE>
+  void
+  add_column(
+    TYPE const* const values,
+    long const length,
+    Number format,
+    long const stride=sizeof(TYPE))
+  {
+    auto seg = make_segment(
+      Segment::kind_of(values), values, numbers_, std::move(format));
+    seg.stride = stride;
+    seg.cache = make_cache(get_values<TYPE>(seg), length, numbers_.back());
+    add_segment(seg, length);
+  }
+
+  /**
+   * Returns the total lookups in the number columns' cell caches.
+   */
+  CellCacheStats
+  get_cell_cache_stats()
+    const
+  {
+    CellCacheStats stats;
+    for (auto const& cache : caches_) {
+      ++stats.num_caches;
+      stats.num_enabled += cache->is_enabled();
+      stats.hits += cache->get_hits();
+      stats.misses += cache->get_misses();
+    }
+    return stats;
+  }
+
+  void
+  add_column(
+    bool const* const values,
+    long const length,
+    Bool format,
+    long const stride=sizeof(bool))
+  {
+    auto seg = make_segment(Segment::BOOL, values, bools_, std::move(format));
+    seg.stride = stride;
+    add_segment(seg, length);
+  }
+
+  void
+  add_column(
+    long const* const values,
+    long const length,
+    TickTime format,
+    long const stride=sizeof(long))
+  {
+    auto seg = make_segment(
+      Segment::TICK_TIME, values, tick_times_, std::move(format));
+    seg.stride = stride;
+    add_segment(seg, length);
+  }
 
+  void
+  add_column(
+    long const* const values,
+    long const length,
+    TickDuration format,
+    long const stride=sizeof(long))
+  {
+    auto seg = make_segment(
+      Segment::TICK_DURATION, values, tick_durations_, std::move(format));
+    seg.stride = stride;
+    add_segment(seg, length);
+  }
+
+  /**
+   * Adds a column of bit-packed bools.  Value 'i' is bit 'bit_offset + i',
+   * counting from the least significant bit of each byte.
+   */
+  void
+  add_bool_bits(
+    uint8_t const* const values,
+    long const bit_offset,
+    long const length,
+    Bool format)
+  {
+    auto seg = make_segment(
+      Segment::BOOL_BITS, values, bools_, std::move(format));
+    seg.bit_offset = bit_offset;
+    add_segment(seg, length);
+  }
+
+  /**
+   * Adds a column of UTF-8 strings, each 'itemsize' bytes and padded on the
+   * right with NULs.
+   */
+  void
+  add_utf8(
+    char const* const values,
+    size_t const itemsize,
+    long const length,
+    String format)
+  {
+    add_utf8(values, itemsize, itemsize, length, std::move(format));
+  }
+
+  void
+  add_utf8(
+    char const* const values,
+    size_t const itemsize,
+    long const stride,
+    long const length,
+    String format)
+  {
+    auto seg = make_segment(Segment::UTF8, values, strings_, std::move(format));
+    seg.itemsize = itemsize;
+    seg.stride = stride;
+    add_segment(seg, length);
+  }
+
+  /**
+   * Adds a column of UCS-4 strings, each 'itemsize' bytes and padded on the
+   * right with NULs.
+   */
+  void
+  add_ucs32(
+    char const* const values,
+    size_t const itemsize,
+    long const length,
+    String format)
+  {
+    add_ucs32(values, itemsize, itemsize, length, std::move(format));
+  }
+
+  void
+  add_ucs32(
+    char const* const values,
+    size_t const itemsize,
+    long const stride,
+    long const length,
+    String format)
+  {
+    assert(itemsize % 4 == 0);
+    auto seg = make_segment(
+      Segment::UCS32, values, strings_, std::move(format));
+    seg.itemsize = itemsize;
+    seg.stride = stride;
+    add_segment(seg, length);
+  }
+
+  /**
+   * Adds a column of UTF-8 strings stored end to end in 'data'.  String 'i'
+   * spans bytes 'offsets[i]' up to 'offsets[i + 1]'.
+   */
+  void
+  add_utf8_offsets(
+    int32_t const* const offsets,
+    char const* const data,
+    long const length,
+    String format)
+  {
+    auto seg = make_segment(
+      Segment::UTF8_OFFSETS32, data, strings_, std::move(format));
+    seg.offsets = offsets;
+    add_segment(seg, length);
+  }
+
+  void
+  add_utf8_offsets(
+    int64_t const* const offsets,
+    char const* const data,
+    long const length,
+    String format)
+  {
+    auto seg = make_segment(
+      Segment::UTF8_OFFSETS64, data, strings_, std::move(format));
+    seg.offsets = offsets;
+    add_segment(seg, length);
+  }
+
+  /**
+   * Adds a column of any other kind.
+   */
   void 
   add_column(
     unique_ptr<Column> col)
   {
-    width_ += col->get_width();
-    length_ = std::min(length_, col->get_length());
+    Segment seg;
+    seg.kind = Segment::COLUMN;
+    seg.format = columns_.size();
+    seg.width = col->get_width();
+    seg.max_bytes = col->get_max_bytes();
+    seg.fixed_bytes = col->is_fixed_bytes();
+    add_segment(seg, col->get_length());
     columns_.push_back(std::move(col));
   }
 
+  /**
+   * True if the most recently added segment is a column, rather than a
+   * string.
+   */
+  bool
+  ends_with_column()
+    const
+  {
+    return !segments_.empty() && segments_.back().kind != Segment::LITERAL;
+  }
+
+  /**
+   * Masks entries of the most recently added column with a validity bitmap.
+   * Entry 'i' is shown as 'null', padded or elided to the column's width,
+   * where bit 'offset + i' of 'valid' is clear.
+   */
+  void
+  set_valid(
+    uint8_t const* const valid,
+    long const offset,
+    string const& null)
+  {
+    assert(!segments_.empty());
+    auto& seg = segments_.back();
+    assert(seg.kind != Segment::LITERAL);
+    auto const null_str = palide(null, seg.width, "", " ");
+    seg.valid = valid;
+    seg.valid_offset = offset;
+    seg.null = literals_.size();
+    literals_.push_back(null_str);
+
+    // Make room for the null string.
+    seg.fixed_bytes = seg.fixed_bytes && null_str.size() == seg.max_bytes;
+    if (null_str.size() > seg.max_bytes) {
+      max_bytes_ += null_str.size() - seg.max_bytes;
+      seg.max_bytes = null_str.size();
+    }
+    fixed_bytes_ = std::all_of(
+      segments_.begin(), segments_.end(), 
+      [](Segment const& s) { return s.fixed_bytes; });
+  }
+
   void 
   add_string(
     string str)
   { 
-    add_column(unique_ptr<Column>(new StringColumn(std::move(str)))); 
+    if (!segments_.empty() && segments_.back().kind == Segment::LITERAL) {
+      // Extend the preceding literal.
+      auto& seg = segments_.back();
+      literals_[seg.format] += str;
+      seg.width += string_length(str);
+      seg.max_bytes += str.size();
+      max_bytes_ += str.size();
+      width_ += string_length(str);
+    }
+    else {
+      Segment seg;
+      seg.kind = Segment::LITERAL;
+      seg.format = literals_.size();
+      seg.width = string_length(str);
+      seg.max_bytes = str.size();
+      add_segment(seg, MAX_INDEX);
+      literals_.push_back(std::move(str));
+    }
   }
 
   virtual int get_width() const override { return width_; }
   virtual long get_length() const override { return length_; }
+  virtual size_t get_max_bytes() const override { return max_bytes_; }
+  virtual bool is_fixed_bytes() const override { return fixed_bytes_; }
+
+  /**
+   * Renders row 'index' and appends it to 'buf'.
+   */
+  void
+  render_row(
+    long const index,
+    string& buf)
+    const
+  {
+    // Make room for the bound, and trim afterward.
+    auto const start = buf.size();
+    buf.resize(start + max_bytes_);
+    char* out = &buf[start];
+    for (size_t s = 0; s < segments_.size(); ++s) {
+      auto const& seg = segments_[s];
+      auto const end = format_cell(seg, index, out);
+      if ((size_t) (end - out) > seg.max_bytes) {
+        // An overlong cell.  Append it and the rest of the row one at a time.
+        buf.resize(out - &buf[0]);
+        for (; s < segments_.size(); ++s)
+          buf += get_cell(segments_[s], index);
+        return;
+      }
+      out = end;
+    }
+    buf.resize(out - &buf[0]);
+  }
+
+  /**
+   * Renders rows 'begin' up to 'end' into 'out', one column at a time.  Each
+   * row is followed by a newline, so row 'i' starts at 
+   * 'out + (i - begin) * (get_max_bytes() + 1)'.
+   *
+   * Requires 'is_fixed_bytes()', so that every cell has a fixed offset.
+   */
+  void
+  render_block(
+    long const begin,
+    long const end,
+    char* const out)
+    const
+  {
+    assert(fixed_bytes_);
+    size_t const stride = max_bytes_ + 1;
+    for (auto const& seg : segments_)
+      format_segment(seg, begin, end, out + seg.offset, stride, nullptr);
+    for (long i = begin; i < end; ++i)
+      out[(i - begin) * stride + max_bytes_] = '\n';
+  }
+
+  /**
+   * Renders rows 'begin' up to 'end' and appends them to 'buf', separated by
+   * newlines.  No newline follows the last row.
+   *
+   * If 'ends' isn't null, appends to it the offset in 'buf' of the end of each
+   * row.  Since cells may contain newlines, these are the row boundaries.
+   *
+   * Renders blocks of rows one column at a time.
+   */
+  void
+  render_rows(
+    long const begin,
+    long const end,
+    string& buf,
+    std::vector<size_t>* const ends=nullptr)
+    const
+  {
+    if (end <= begin)
+      return;
+
+    // Make room for the bound, and trim afterward.
+    size_t const stride = max_bytes_ + 1;
+    size_t pos = buf.size();
+    buf.resize(pos + (end - begin) * stride);
+    string overflow;
+    std::vector<size_t> block_ends(ends == nullptr ? 0 : BLOCK_SIZE);
+    for (long i = begin; i < end; i += BLOCK_SIZE) {
+      long const block_end = std::min(i + BLOCK_SIZE, end);
+      auto const block_pos = pos;
+      auto const block_ends_ptr = ends == nullptr ? nullptr : &block_ends[0];
+      if (auto const out = render_lines(
+            i, block_end, &buf[pos], overflow, block_ends_ptr))
+        pos = out - &buf[0];
+      else {
+        // The block has overlong cells.  Append it, and make room again.
+        buf.resize(pos);
+        buf += overflow;
+        pos = buf.size();
+        buf.resize(pos + (end - block_end) * stride);
+      }
+      if (ends != nullptr)
+        for (long r = 0; r < block_end - i; ++r)
+          ends->push_back(block_pos + block_ends[r]);
+    }
+    // Drop the last newline.
+    buf.resize(pos - 1);
+  }
+
+  /**
+   * Like 'render_rows', but renders blocks of rows on up to 'num_threads'
+   * threads.
+   *
+   * Each block is rendered directly into its own slice of the output buffer.
+   * Blocks are scheduled with work stealing, since rows of some columns cost
+   * far more to render than others.  Columns must be safe to format from
+   * multiple threads at once.
+   */
+  void
+  render_parallel(
+    long const begin,
+    long const end,
+    string& buf,
+    int const num_threads)
+    const
+  {
+    if (end <= begin)
+      return;
+
+    // Make room for the bound.
+    size_t const stride = max_bytes_ + 1;
+    auto const start = buf.size();
+    buf.resize(start + (end - begin) * stride);
+    char* const out = &buf[start];
+
+    // Render each block at its bound offset, and note its actual size.  A
+    // block with overlong cells is rendered into its own overflow string.
+    long const num_blocks = (end - begin + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<size_t> sizes(num_blocks);
+    std::vector<string> overflows(num_blocks);
+    run_parallel(num_blocks, num_threads, [&](long const block) {
+      long const block_begin = begin + block * BLOCK_SIZE;
+      long const block_end = std::min(block_begin + BLOCK_SIZE, end);
+      char* const block_out = out + block * BLOCK_SIZE * stride;
+      auto const block_end_out 
+        = render_lines(block_begin, block_end, block_out, overflows[block]);
+      sizes[block] 
+        = block_end_out == nullptr ? 0 : block_end_out - block_out;
+    });
+
+    if (std::all_of(
+          overflows.begin(), overflows.end(), 
+          [](string const& o) { return o.empty(); })) {
+      // Close up any gaps between blocks.
+      char* pos = out;
+      for (long block = 0; block < num_blocks; ++block) {
+        char* const block_out = out + block * BLOCK_SIZE * stride;
+        if (pos != block_out)
+          memmove(pos, block_out, sizes[block]);
+        pos += sizes[block];
+      }
+      // Drop the last newline.
+      buf.resize(pos - &buf[0] - 1);
+    }
+    else {
+      // Some blocks may not fit in place; assemble the blocks anew.
+      string result(buf, 0, start);
+      for (long block = 0; block < num_blocks; ++block)
+        if (overflows[block].empty())
+          result.append(out + block * BLOCK_SIZE * stride, sizes[block]);
+        else
+          result += overflows[block];
+      // Drop the last newline.
+      result.pop_back();
+      buf.swap(result);
+    }
+  }
+
+  virtual char* format(long const index, char* const buf) const override
+  {
+    char* out = buf;
+    for (auto const& seg : segments_) {
+      auto const end = format_cell(seg, index, out);
+      if ((size_t) (end - out) > seg.max_bytes)
+        // An overlong cell; the row doesn't fit.
+        return buf + (*this)(index).size();
+      out = end;
+    }
+    return out;
+  }
 
   virtual string 
   operator()(
     long const index) 
     const override
   {
-    std::stringstream result;
-    for (auto i = columns_.begin(); i != columns_.end(); ++i)
-      result << (**i)(index);
-    return result.str();
+    string result;
+    render_row(index, result);
+    return result;
   }
 
 private:
 
+  /**
+   * One piece of a row: a literal string, or a column of one of the kinds the
+   * table formats directly, or any other column.
+   */
+  struct Segment
+  {
+    enum Kind
+    {
+      LITERAL,
+      INT8, INT16, INT32, INT64,
+      UINT8, UINT16, UINT32, UINT64,
+      FLOAT32, FLOAT64,
+      BOOL,
+      TICK_TIME,
+      TICK_DURATION,
+      BOOL_BITS,
+      UTF8,
+      UCS32,
+      UTF8_OFFSETS32,
+      UTF8_OFFSETS64,
+      COLUMN,
+    };
+
+    // Integers map to kinds by size and signedness, so that 'long' and 'long
+    // long' are read as whichever fixed-width type they match.
+    template<typename TYPE>
+    static constexpr std::enable_if_t<
+      std::is_integral<TYPE>::value && !std::is_same<TYPE, bool>::value, Kind>
+    kind_of(
+      TYPE const*)
+    {
+      static_assert(sizeof(TYPE) <= sizeof(int64_t), "integer too wide");
+      return
+          sizeof(TYPE) == 1 ? (std::is_signed<TYPE>::value ? INT8  : UINT8)
+        : sizeof(TYPE) == 2 ? (std::is_signed<TYPE>::value ? INT16 : UINT16)
+        : sizeof(TYPE) == 4 ? (std::is_signed<TYPE>::value ? INT32 : UINT32)
+        :                     (std::is_signed<TYPE>::value ? INT64 : UINT64);
+    }
+
+    static constexpr Kind kind_of(float const*)             { return FLOAT32; }
+    static constexpr Kind kind_of(double const*)            { return FLOAT64; }
+
+    Kind kind;
+    // The column's values, or null for a literal or other column.
+    void const* values = nullptr;
+    // For offset string columns, the offsets of the strings in 'values'.
+    void const* offsets = nullptr;
+    // Size of each value, for fixed-size string columns.
+    size_t itemsize = 0;
+    // Bytes between values.
+    long stride = 0;
+    // For bit-packed columns, the bit index of the first value.
+    long bit_offset = 0;
+    // Index of the literal, formatter, or other column, in the vector for
+    // this kind.
+    size_t format = 0;
+    // Byte offset of the segment in a row, given the segments' byte bounds.
+    size_t offset = 0;
+    int width = 0;
+    size_t max_bytes = 0;
+    bool fixed_bytes = true;
+    // Validity bitmap, or null if all values are valid, and the bit index of
+    // the first value in it.
+    uint8_t const* valid = nullptr;
+    long valid_offset = 0;
+    // Index of the literal shown for invalid values.
+    size_t null = 0;
+    // Index of the cell cache, or -1 for none.
+    int cache = -1;
+  };
+
+  /**
+   * Returns a segment of 'kind' formatted with 'format', which is added to
+   * 'formats'.
+   */
+  template<typename FMT>
+  Segment
+  make_segment(
+    Segment::Kind const kind,
+    void const* const values,
+    std::vector<FMT>& formats,
+    FMT format)
+  {
+    Segment seg;
+    seg.kind = kind;
+    seg.values = values;
+    seg.format = formats.size();
+    seg.width = format.get_width();
+    seg.max_bytes = format.get_max_bytes();
+    seg.fixed_bytes = format.is_fixed_bytes();
+    formats.push_back(std::move(format));
+    return seg;
+  }
+
+  void
+  add_segment(
+    Segment seg,
+    long const length)
+  {
+    seg.offset = max_bytes_;
+    width_ += seg.width;
+    max_bytes_ += seg.max_bytes;
+    fixed_bytes_ = fixed_bytes_ && seg.fixed_bytes;
+    length_ = std::min(length_, length);
+    segments_.push_back(seg);
+  }
+
+  static bool
+  get_bit(
+    uint8_t const* const bits,
+    long const index)
+  {
+    return (bits[index >> 3] >> (index & 7)) & 1;
+  }
+
+  /**
+   * Samples the first block of a number column's values.  If they're few
+   * enough, creates a cache of formatted cells with them, and returns its
+   * index.  Otherwise returns -1.
+   */
+  template<typename GET>
+  int
+  make_cache(
+    GET const& get,
+    long const length,
+    Number const& format)
+  {
+    if (length <= BLOCK_SIZE)
+      return -1;
+
+    unique_ptr<CellCache> cache(
+      new CellCache(CACHE_MAX_ENTRIES, format.get_max_bytes()));
+    string cell(format.get_max_bytes(), '\0');
+    size_t num_sampled = 0;
+    for (long i = 0; i < BLOCK_SIZE; ++i) {
+      auto const val = get(i);
+      auto const key = CellCache::key_of(val);
+      size_t size;
+      if (cache->find(key, size) == nullptr) {
+        if (++num_sampled > CACHE_MAX_SAMPLED)
+          return -1;
+        size = format.format(val, &cell[0]) - &cell[0];
+        cache->insert(key, cell.data(), size);
+      }
+    }
+
+    caches_.push_back(std::move(cache));
+    return caches_.size() - 1;
+  }
+
+  /**
+   * Formats rows 'begin' up to 'end' of a column through a cell cache, like
+   * 'format_values()'.  Formats and caches values not yet cached.
+   */
+  template<typename GET>
+  static void
+  format_cached(
+    CellCache& cache,
+    Number const& fmt,
+    GET const& get,
+    long const begin,
+    long const end,
+    char* out,
+    size_t const stride,
+    size_t* sizes)
+  {
+    long hits = 0;
+    for (long i = begin; i < end; ++i, out += stride) {
+      auto const val = get(i);
+      auto const key = CellCache::key_of(val);
+      size_t size;
+      if (auto const cell = cache.find(key, size)) {
+        memcpy(out, cell, size);
+        ++hits;
+      }
+      else {
+        size = fmt.format(val, out) - out;
+        cache.insert(key, out, size);
+      }
+      if (sizes != nullptr)
+        *sizes++ = size;
+    }
+    cache.record(hits, end - begin - hits);
+  }
+
+  /**
+   * Returns 'num' bits, at most 64, starting at bit 'index', as a word with the
+   * first in the least significant bit.  Reads only the bytes that hold them.
+   */
+  static uint64_t
+  get_bits(
+    uint8_t const* const bits,
+    long const index,
+    long const num)
+  {
+    assert(0 < num && num <= 64);
+    auto const ptr = bits + (index >> 3);
+    int const shift = index & 7;
+    long const num_bytes = (shift + num + 7) >> 3;
+
+    uint64_t word = 0;
+    for (long b = 0; b < std::min(num_bytes, 8l); ++b)
+      word |= (uint64_t) ptr[b] << (8 * b);
+    word >>= shift;
+    if (num_bytes > 8)
+      word |= (uint64_t) ptr[8] << (64 - shift);
+    return num < 64 ? word & (((uint64_t) 1 << num) - 1) : word;
+  }
+
+  static bool
+  is_valid(
+    Segment const& seg,
+    long const index)
+  {
+    return seg.valid == nullptr || get_bit(seg.valid, seg.valid_offset + index);
+  }
+
+  template<typename OFFSET>
+  static auto
+  get_offset_strings(
+    Segment const& seg)
+  {
+    auto const offsets = static_cast<OFFSET const*>(seg.offsets);
+    auto const data = static_cast<char const*>(seg.values);
+    return [offsets, data](long const i) {
+      return string(data + offsets[i], offsets[i + 1] - offsets[i]);
+    };
+  }
+
+  template<typename TYPE>
+  static auto
+  get_values(
+    Segment const& seg)
+  {
+    auto const values = static_cast<char const*>(seg.values);
+    auto const stride = seg.stride;
+    return [values, stride](long const i) {
+      return load<TYPE>(values + i * stride);
+    };
+  }
+
+  /**
+   * Like 'visit()', for a segment of a number column only.
+   */
+  template<typename FN>
+  void
+  visit_number(
+    Segment const& seg,
+    FN&& fn)
+    const
+  {
+    switch (seg.kind) {
+    case Segment::INT8:
+      fn(numbers_[seg.format], get_values<int8_t>(seg)); break;
+    case Segment::INT16:
+      fn(numbers_[seg.format], get_values<int16_t>(seg)); break;
+    case Segment::INT32:
+      fn(numbers_[seg.format], get_values<int32_t>(seg)); break;
+    case Segment::INT64:
+      fn(numbers_[seg.format], get_values<int64_t>(seg)); break;
+    case Segment::UINT8:
+      fn(numbers_[seg.format], get_values<uint8_t>(seg)); break;
+    case Segment::UINT16:
+      fn(numbers_[seg.format], get_values<uint16_t>(seg)); break;
+    case Segment::UINT32:
+      fn(numbers_[seg.format], get_values<uint32_t>(seg)); break;
+    case Segment::UINT64:
+      fn(numbers_[seg.format], get_values<uint64_t>(seg)); break;
+    case Segment::FLOAT32:
+      fn(numbers_[seg.format], get_values<float>(seg)); break;
+    case Segment::FLOAT64:
+      fn(numbers_[seg.format], get_values<double>(seg)); break;
+    default:
+      assert(false);
+    }
+  }
+
+  /**
+   * Calls 'fn(fmt, get)' for a segment of a directly-formatted column, where
+   * 'fmt' is its formatter and 'get(i)' returns its value 'i'.
+   */
+  template<typename FN>
+  void
+  visit(
+    Segment const& seg,
+    FN&& fn)
+    const
+  {
+    switch (seg.kind) {
+    case Segment::INT8:
+    case Segment::INT16:
+    case Segment::INT32:
+    case Segment::INT64:
+    case Segment::UINT8:
+    case Segment::UINT16:
+    case Segment::UINT32:
+    case Segment::UINT64:
+    case Segment::FLOAT32:
+    case Segment::FLOAT64:
+      visit_number(seg, fn); break;
+    case Segment::BOOL:
+      fn(bools_[seg.format], get_values<bool>(seg)); break;
+    case Segment::TICK_TIME:
+      fn(tick_times_[seg.format], get_values<long>(seg)); break;
+    case Segment::TICK_DURATION:
+      fn(tick_durations_[seg.format], get_values<long>(seg)); break;
+
+    case Segment::UTF8:
+      fn(strings_[seg.format], [&seg](long const i) {
+        // Skip NUL padding on the right.
+        auto const ptr = static_cast<char const*>(seg.values) + i * seg.stride;
+        return string(ptr, strnlen(ptr, seg.itemsize));
+      });
+      break;
+
+    case Segment::UCS32:
+      fn(strings_[seg.format], [&seg](long const i) {
+        // Copy the code points out, since strided strings needn't be aligned.
+        std::vector<char32_t> chars(seg.itemsize / 4);
+        memcpy(
+          chars.data(), static_cast<char const*>(seg.values) + i * seg.stride,
+          chars.size() * sizeof(char32_t));
+        return utf8_from_ucs4(chars.data(), chars.size());
+      });
+      break;
+
+    case Segment::BOOL_BITS:
+      fn(bools_[seg.format], [&seg](long const i) {
+        return get_bit(
+          static_cast<uint8_t const*>(seg.values), seg.bit_offset + i);
+      });
+      break;
+
+    case Segment::UTF8_OFFSETS32:
+      fn(strings_[seg.format], get_offset_strings<int32_t>(seg)); break;
+    case Segment::UTF8_OFFSETS64:
+      fn(strings_[seg.format], get_offset_strings<int64_t>(seg)); break;
+
+    case Segment::LITERAL:
+    case Segment::COLUMN:
+      assert(false);
+      break;
+    }
+  }
+
+  /**
+   * Formats row 'index' of one segment into 'out'.  Returns the end of the
+   * formatted cell.
+   */
+  char*
+  format_cell(
+    Segment const& seg,
+    long const index,
+    char* out)
+    const
+  {
+    if (!is_valid(seg, index)) {
+      auto const& null = literals_[seg.null];
+      memcpy(out, null.data(), null.size());
+      return out + null.size();
+    }
+
+    switch (seg.kind) {
+    case Segment::LITERAL:
+      memcpy(out, literals_[seg.format].data(), seg.max_bytes);
+      return out + seg.max_bytes;
+
+    case Segment::COLUMN:
+      return columns_[seg.format]->format(index, out);
+
+    default:
+      visit(seg, [&](auto const& fmt, auto const& get) {
+        out = fmt.format(get(index), out);
+      });
+      return out;
+    }
+  }
+
+  /**
+   * Returns row 'index' of one segment, however long.
+   */
+  string
+  get_cell(
+    Segment const& seg,
+    long const index)
+    const
+  {
+    if (!is_valid(seg, index))
+      return literals_[seg.null];
+
+    switch (seg.kind) {
+    case Segment::LITERAL:
+      return literals_[seg.format];
+
+    case Segment::COLUMN:
+      return (*columns_[seg.format])(index);
+
+    default:
+      string cell;
+      visit(seg, [&](auto const& fmt, auto const& get) {
+        cell = fmt(get(index));
+      });
+      return cell;
+    }
+  }
+
+  /**
+   * Formats rows 'begin' up to 'end' of one segment, writing row 'i' at
+   * 'out + (i - begin) * stride'.  If 'sizes' is not null, stores the size of
+   * each formatted cell in it.
+   *
+   * Checks validity 64 rows at a time, so that runs without nulls, or with
+   * only nulls, don't check each row.
+   */
+  void
+  format_segment(
+    Segment const& seg,
+    long const begin,
+    long const end,
+    char* out,
+    size_t const stride,
+    size_t* sizes)
+    const
+  {
+    if (seg.valid == nullptr) {
+      format_values(seg, begin, end, out, stride, sizes);
+      return;
+    }
+
+    auto const& null = literals_[seg.null];
+    for (long i = begin; i < end; ) {
+      long const num = std::min(end - i, 64l);
+      auto const bits = get_bits(seg.valid, seg.valid_offset + i, num);
+      if (bits == (num < 64 ? ((uint64_t) 1 << num) - 1 : ~(uint64_t) 0))
+        // All valid.
+        format_values(seg, i, i + num, out, stride, sizes);
+      else if (bits == 0)
+        // All null.
+        for (long j = 0; j < num; ++j) {
+          memcpy(out + j * stride, null.data(), null.size());
+          if (sizes != nullptr)
+            sizes[j] = null.size();
+        }
+      else
+        for (long j = 0; j < num; ++j) {
+          auto const cell = out + j * stride;
+          auto const size = format_cell(seg, i + j, cell) - cell;
+          if (sizes != nullptr)
+            sizes[j] = size;
+        }
+
+      i += num;
+      out += num * stride;
+      if (sizes != nullptr)
+        sizes += num;
+    }
+  }
+
+  /**
+   * Like 'format_segment()', but ignores validity.
+   */
+  void
+  format_values(
+    Segment const& seg,
+    long const begin,
+    long const end,
+    char* out,
+    size_t const stride,
+    size_t* sizes)
+    const
+  {
+    switch (seg.kind) {
+    case Segment::LITERAL:
+      for (long i = begin; i < end; ++i, out += stride)
+        memcpy(out, literals_[seg.format].data(), seg.max_bytes);
+      break;
+
+    case Segment::COLUMN:
+      columns_[seg.format]->format_block(begin, end, out, stride, sizes);
+      break;
+
+    case Segment::BOOL_BITS:
+      format_bool_bits(seg, begin, end, out, stride, sizes);
+      break;
+
+    default:
+      // Only number columns have caches.
+      if (seg.cache >= 0 && caches_[seg.cache]->is_enabled()) {
+        visit_number(seg, [&](auto const& fmt, auto const& get) {
+          format_cached(
+            *caches_[seg.cache], fmt, get, begin, end, out, stride, sizes);
+        });
+        break;
+      }
+      visit(seg, [&](auto const& fmt, auto const& get) {
+        if (sizes == nullptr)
+          for (long i = begin; i < end; ++i, out += stride)
+            fmt.format(get(i), out);
+        else
+          for (long i = begin; i < end; ++i, out += stride)
+            *sizes++ = fmt.format(get(i), out) - out;
+      });
+      break;
+    }
+  }
+
+  /**
+   * Like 'format_values()', for a segment of bit-packed bools.  Reads 64 values
+   * at a time, and copies the formatter's true and false strings.
+   */
+  void
+  format_bool_bits(
+    Segment const& seg,
+    long const begin,
+    long const end,
+    char* out,
+    size_t const stride,
+    size_t* sizes)
+    const
+  {
+    auto const values = static_cast<uint8_t const*>(seg.values);
+    auto const& true_str = bools_[seg.format].get_str(true);
+    auto const& false_str = bools_[seg.format].get_str(false);
+    for (long i = begin; i < end; ) {
+      long const num = std::min(end - i, 64l);
+      auto bits = get_bits(values, seg.bit_offset + i, num);
+      for (long j = 0; j < num; ++j, bits >>= 1, out += stride) {
+        auto const& str = bits & 1 ? true_str : false_str;
+        memcpy(out, str.data(), str.size());
+        if (sizes != nullptr)
+          *sizes++ = str.size();
+      }
+      i += num;
+    }
+  }
+
+  /**
+   * Renders rows 'begin' up to 'end' into 'out', each followed by a newline.
+   * 'out' must have room for '(end - begin) * (get_max_bytes() + 1)' bytes.
+   * Returns the end of the output.
+   *
+   * Formats one column at a time, with each cell at its bound offset.  If
+   * some cells may be shorter, closes up the gaps afterward.  If some cells
+   * are longer than their bounds, the rows may not fit; instead renders them
+   * into 'overflow', and returns null.
+   *
+   * If 'ends' isn't null, stores there the offset of each row's newline, in
+   * 'out' or in 'overflow'.
+   */
+  char*
+  render_lines(
+    long const begin,
+    long const end,
+    char* const out,
+    string& overflow,
+    size_t* const ends=nullptr)
+    const
+  {
+    long const num_rows = end - begin;
+    size_t const stride = max_bytes_ + 1;
+    if (fixed_bytes_) {
+      render_block(begin, end, out);
+      if (ends != nullptr)
+        for (long r = 0; r < num_rows; ++r)
+          ends[r] = r * stride + max_bytes_;
+      return out + num_rows * stride;
+    }
+
+    // Format each segment, noting cell sizes where they may vary.
+    std::vector<size_t> sizes(segments_.size() * num_rows);
+    for (size_t s = 0; s < segments_.size(); ++s) {
+      auto const& seg = segments_[s];
+      format_segment(
+        seg, begin, end, out + seg.offset, stride,
+        seg.fixed_bytes ? nullptr : &sizes[s * num_rows]);
+    }
+
+    bool overlong = false;
+    for (size_t s = 0; s < segments_.size(); ++s)
+      if (!segments_[s].fixed_bytes)
+        overlong = overlong || std::any_of(
+          &sizes[s * num_rows], &sizes[(s + 1) * num_rows],
+          [&](size_t const size) { return size > segments_[s].max_bytes; });
+    if (overlong) {
+      // Copy the cells that fit, and format the overlong ones again in full.
+      overflow.clear();
+      for (long r = 0; r < num_rows; ++r) {
+        for (size_t s = 0; s < segments_.size(); ++s) {
+          auto const& seg = segments_[s];
+          auto const size 
+            = seg.fixed_bytes ? seg.max_bytes : sizes[s * num_rows + r];
+          if (size <= seg.max_bytes)
+            overflow.append(out + r * stride + seg.offset, size);
+          else
+            overflow += get_cell(seg, begin + r);
+        }
+        if (ends != nullptr)
+          ends[r] = overflow.size();
+        overflow += '\n';
+      }
+      return nullptr;
+    }
+
+    // Close up the gaps.  Each cell moves toward the front, so never
+    // overwrites cells still to be moved.
+    char* pos = out;
+    for (long r = 0; r < num_rows; ++r) {
+      for (size_t s = 0; s < segments_.size(); ++s) {
+        auto const& seg = segments_[s];
+        auto const size 
+          = seg.fixed_bytes ? seg.max_bytes : sizes[s * num_rows + r];
+        char const* const cell = out + r * stride + seg.offset;
+        if (pos != cell)
+          memmove(pos, cell, size);
+        pos += size;
+      }
+      if (ends != nullptr)
+        ends[r] = pos - out;
+      *pos++ = '\n';
+    }
+    return pos;
+  }
+
+  std::vector<Segment> segments_;
+
+  // Literals, formatters, and other columns, referenced by segments.
+  std::vector<string> literals_;
+  std::vector<Number> numbers_;
+  std::vector<Bool> bools_;
+  std::vector<TickTime> tick_times_;
+  std::vector<TickDuration> tick_durations_;
+  std::vector<String> strings_;
   std::vector<unique_ptr<Column>> columns_;
+  // Caches of formatted cells, for some number columns.
+  std::vector<unique_ptr<CellCache>> caches_;
+
   int width_;
   long length_;
+  // Upper bound on the number of bytes in a rendered row.
+  size_t max_bytes_;
+  // True if every column has fixed bytes.
+  bool fixed_bytes_;
 
 };
 
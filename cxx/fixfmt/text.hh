@@ -12,9 +12,9 @@ namespace {
 
 inline bool
 within(
-  unsigned char min, 
-  unsigned char val, 
-  unsigned char max)
+  char32_t min, 
+  char32_t val, 
+  char32_t max)
   noexcept
 {
   return min <= val && val <= max;
@@ -37,9 +37,10 @@ constexpr char ANSI_ESCAPE = '\x1b';
  *
  * FIXME: Take an end parameter.
  */
+template<typename ITER>
 inline bool
 next_utf8(
-  string::const_iterator& i)
+  ITER& i)
   noexcept
 {
   unsigned char c = *i++;
@@ -81,12 +82,53 @@ utf8_length(
 
 
 /*
- * Advances an iterator past an ANSI escape sequence, if at one.
+ * Encodes UTF-8 from up to `length` UCS-4 code points, stopping at the first
+ * NUL.
+ *
+ * FIXME: Is this always right?
  */
+inline string
+utf8_from_ucs4(
+  char32_t const* const ptr,
+  size_t const length)
+{
+  string s;
+  for (size_t i = 0; i < length; i++) {
+    auto const c = ptr[i];
+    if (c == 0)
+      // Skip trailing NULs.
+      break;
+    else if (c < 0x80)
+      s.push_back(c);
+    else if (c < 0x800) {
+      s.push_back(192 | ( c >> 6       ));
+      s.push_back(128 | ( c        & 63));
+    }
+    else if (c < 0x10000) {
+      s.push_back(224 | ( c >> 12      ));
+      s.push_back(128 | ((c >>  6) & 63));
+      s.push_back(128 | ( c        & 63));
+    }
+    else {
+      s.push_back(240 | ( c >> 18      ));
+      s.push_back(128 | ((c >> 12) & 63));
+      s.push_back(128 | ((c >>  6) & 63));
+      s.push_back(128 | ( c        & 63));
+    }
+  }
+  return s;
+}
+
+
+/*
+ * Advances an iterator past an ANSI escape sequence, if at one.  The iterator
+ * may be on UTF-8 or on code points.
+ */
+template<typename ITER>
 inline bool
 skip_ansi_escape(
-  string::const_iterator& i, 
-  string::const_iterator const& end)
+  ITER& i, 
+  ITER const& end)
   noexcept
 {
   assert(i != end);
@@ -106,6 +148,30 @@ skip_ansi_escape(
 }
 
 
+/*
+ * Returns the number of code points in UTF-8 from `begin` to `end`, skipping
+ * escape sequences.  A malformed last code point counts as one.
+ */
+template<typename ITER>
+inline size_t
+string_length(
+  ITER i,
+  ITER const end)
+  noexcept
+{
+  size_t length = 0;
+  // Count characters.
+  while (i < end)
+    if (skip_ansi_escape(i, end))
+      ;
+    else {
+      ++length;
+      next_utf8(i);
+    }
+  return length;
+}
+
+
 /*
  * Returns the number of code points in a UTF-8-encoded string, skipping
  * escape sequences.
@@ -114,17 +180,29 @@ inline size_t
 string_length(
   string const& str)
   noexcept
+{
+  return string_length(str.begin(), str.end());
+}
+
+
+/*
+ * Returns the number of code points from `begin` to `end` in a fixed-width
+ * encoding, such as UCS-4, skipping escape sequences.
+ */
+template<typename CHAR>
+inline size_t
+code_point_length(
+  CHAR const* i,
+  CHAR const* const end)
+  noexcept
 {
   size_t length = 0;
-  auto const& end = str.end();
-  // FIXME: Problem if the last code point is malformed.
-  // Count characters.
-  for (auto i = str.begin(); i != end; ) 
+  while (i != end)
     if (skip_ansi_escape(i, end))
       ;
     else {
       ++length;
-      next_utf8(i);
+      ++i;
     }
   return length;
 }
@@ -1,4 +1,5 @@
 #include <cassert>
+#include <cstring>
 #include <ctime>
 
 #include "time.hh"
@@ -12,8 +13,23 @@ TickTime::operator()(
   long val) 
   const 
 {
-  if (val == NAT_VALUE)
-    return nat_;
+  string result(max_bytes_, '?');
+  char* const buf = &result[0];
+  result.resize(format(val, buf) - buf);
+  return result;
+}
+
+
+char*
+TickTime::format(
+  long const val,
+  char* const buf)
+  const
+{
+  if (val == NAT_VALUE) {
+    memcpy(buf, nat_.data(), nat_.size());
+    return buf + nat_.size();
+  }
 
   // FIXME: Validate range.
 
@@ -43,22 +59,25 @@ TickTime::operator()(
 
   // Break down the whole number of seconds into time components.
   struct tm time;
-  if (gmtime_r(&whole, &time) == NULL) 
-    return bad_result_;
+  if (gmtime_r(&whole, &time) == NULL) {
+    memcpy(buf, bad_result_.data(), width_);
+    return buf + width_;
+  }
 
   // Render the time in whole seconds.
-  string result(width_, '?');
-  size_t pos = strftime(&result[0], width_, "%Y-%m-%dT%H:%M:%S", &time);
-  if (pos != 19)
-    return bad_result_;
+  size_t pos = strftime(buf, width_, "%Y-%m-%dT%H:%M:%S", &time);
+  if (pos != 19) {
+    memcpy(buf, bad_result_.data(), width_);
+    return buf + width_;
+  }
 
   // Tack on subsecond precision, if indicated.
-  if (prec_ > 0) {
+  if (precision_ != PRECISION_NONE) {
     // Decimal point.
-    result[pos++] = '.';
+    buf[pos++] = '.';
     // Render digits of the fractional seconds.
     for (int i = 0; i < prec_; ++i) {
-      result[pos + prec_ - 1 - i] = '0' + frac % 10;
+      buf[pos + prec_ - 1 - i] = '0' + frac % 10;
       frac /= 10;
     }
     assert(frac == 0);
@@ -66,18 +85,138 @@ TickTime::operator()(
   }
 
   // UTC offset.
-  result[pos++] = '+';
-  result[pos++] = '0';
-  result[pos++] = '0';
-  result[pos++] = ':';
-  result[pos++] = '0';
-  result[pos++] = '0';
+  buf[pos++] = '+';
+  buf[pos++] = '0';
+  buf[pos++] = '0';
+  buf[pos++] = ':';
+  buf[pos++] = '0';
+  buf[pos++] = '0';
 
   assert(pos == width_);
+  return buf + pos;
+}
+
+
+//------------------------------------------------------------------------------
+
+string
+TickDuration::operator()(
+  long val)
+  const
+{
+  string result(max_bytes_, ' ');
+  char* const buf = &result[0];
+  result.resize(format(val, buf) - buf);
   return result;
 }
 
 
+char*
+TickDuration::format_bad(
+  char* const buf)
+  const
+{
+  memcpy(buf, bad_result_.data(), width_);
+  return buf + width_;
+}
+
+
+char*
+TickDuration::format(
+  long const val,
+  char* const buf)
+  const
+{
+  if (val == TickTime::NAT_VALUE) {
+    memcpy(buf, nat_.data(), nat_.size());
+    return buf + nat_.size();
+  }
+
+  bool const nonneg = val >= 0;
+  if (!nonneg && sign_ == SIGN_NONE)
+    return format_bad(buf);
+  // Work with the magnitude; negating in unsigned arithmetic can't overflow.
+  unsigned long const mag = nonneg ? val : -(unsigned long) val;
+
+  // Find the whole number of seconds, and the fractional seconds scaled up
+  // by pow10(precision).
+  unsigned long whole;
+  unsigned long frac;
+  if (round_scale_) {
+    // Round at required precision, half to even.
+    unsigned long rounded = mag / round_scale_;
+    unsigned long const rem = mag % round_scale_;
+    if (2 * rem > (unsigned long) round_scale_
+        || (2 * rem == (unsigned long) round_scale_ && rounded % 2 == 1))
+      ++rounded;
+    whole = rounded / prec_scale_;
+    frac = rounded % prec_scale_;
+  }
+  else {
+    // More precision than available.
+    whole = mag / scale_;
+    frac = (mag % scale_) * (prec_scale_ / scale_);
+  }
+
+  unsigned long const secs = whole % 60;
+  unsigned long const mins = whole / 60 % 60;
+  unsigned long hours = whole / 3600;
+
+  char* pos = buf;
+  int const sign_len = sign_ == SIGN_NONE ? 0 : 1;
+  if (day_size_ > 0) {
+    unsigned long days = hours / 24;
+    hours %= 24;
+    // Right-justify the days, with the sign just before the first digit.
+    int const size = sign_len + day_size_;
+    memset(pos, ' ', size);
+    int i = size;
+    do {
+      pos[--i] = '0' + days % 10;
+      days /= 10;
+    } while (i > sign_len && days > 0);
+    if (days > 0)
+      // Too many days.
+      return format_bad(buf);
+    if (sign_len > 0)
+      pos[i - 1] = nonneg ? (sign_ == SIGN_ALWAYS ? '+' : ' ') : '-';
+    pos += size;
+    *pos++ = 'd';
+    *pos++ = ' ';
+  }
+  else {
+    if (hours >= 100)
+      // No room for the hours.
+      return format_bad(buf);
+    if (sign_len > 0)
+      *pos++ = nonneg ? (sign_ == SIGN_ALWAYS ? '+' : ' ') : '-';
+  }
+
+  *pos++ = '0' + hours / 10;
+  *pos++ = '0' + hours % 10;
+  *pos++ = ':';
+  *pos++ = '0' + mins / 10;
+  *pos++ = '0' + mins % 10;
+  *pos++ = ':';
+  *pos++ = '0' + secs / 10;
+  *pos++ = '0' + secs % 10;
+
+  // Tack on subsecond precision, if indicated.
+  if (precision_ != PRECISION_NONE) {
+    *pos++ = '.';
+    for (int i = prec_ - 1; i >= 0; --i) {
+      pos[i] = '0' + frac % 10;
+      frac /= 10;
+    }
+    assert(frac == 0);
+    pos += prec_;
+  }
+
+  assert(pos - buf == (long) width_);
+  return pos;
+}
+
+
 //------------------------------------------------------------------------------
 
 }  // namespace fixfmt
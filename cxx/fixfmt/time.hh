@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <string>
 
@@ -38,6 +39,7 @@ public:
     scale_(scale),
     precision_(precision),
     nat_(palide(nat, width_, "", " ", 1, PAD_POS_LEFT_JUSTIFY)),
+    max_bytes_(std::max(width_, nat_.size())),
     prec_(precision_ == PRECISION_NONE ? 0 : precision_),
     prec_scale_(pow10(prec_)),
     round_scale_(scale_ > prec_scale_ ? scale_ / prec_scale_ : 0)
@@ -49,9 +51,22 @@ public:
   long          get_scale()     const { return scale_; }
   int           get_precision() const { return precision_; }
   string const& get_nat()       const { return nat_; }
+
+  /*
+   * The maximum number of bytes in one formatted value.  This may exceed the
+   * width if the NaT string contains multibyte characters.
+   */
+  size_t        get_max_bytes() const { return max_bytes_; }
+  bool          is_fixed_bytes() const { return nat_.size() == width_; }
   
   string operator()(long val) const;
 
+  /*
+   * Formats `val` into `buf`, which must have room for `get_max_bytes()`
+   * bytes.  Returns the end of the formatted value.
+   */
+  char* format(long val, char* buf) const;
+
 private:
 
   size_t    const width_;
@@ -60,6 +75,96 @@ private:
   long      const scale_;
   int       const precision_;
   string    const nat_;
+  size_t    const max_bytes_;
+
+  // Intermediate values used in formatting computation.
+  int       const prec_;
+  long      const prec_scale_;
+  long      const round_scale_;
+
+};
+
+
+//------------------------------------------------------------------------------
+
+/*
+ * Fixed-width formatter for durations represented as `long` ticks, for
+ * instance numpy.timedelta64 values.
+ *
+ * A duration is formatted as `[sign][days]d HH:MM:SS[.fff]`.  If `day_size` is
+ * zero, the day field is omitted, and durations of 100 hours or more cannot be
+ * formatted.  Formatting uses integer arithmetic only.
+ */
+class TickDuration
+{
+public:
+
+  constexpr static char SIGN_NONE      = ' ';
+  constexpr static char SIGN_NEGATIVE  = '-';
+  constexpr static char SIGN_ALWAYS    = '+';
+
+  constexpr static int PRECISION_NONE = -1;
+
+  TickDuration(
+    long    const  scale    =TickTime::SCALE_SEC,
+    int     const  precision=PRECISION_NONE,
+    int     const  day_size =0,
+    char    const  sign     =SIGN_NEGATIVE,
+    string  const& nat      ="NaT")
+  : width_(
+        (sign == SIGN_NONE ? 0 : 1)
+      + (day_size > 0 ? day_size + 2 : 0)
+      + 8
+      + (precision == PRECISION_NONE ? 0 : 1 + precision)),
+    bad_result_(width_, '#'),
+    scale_(scale),
+    precision_(precision),
+    day_size_(day_size),
+    sign_(sign),
+    nat_(palide(nat, width_, "", " ", 1, PAD_POS_LEFT_JUSTIFY)),
+    max_bytes_(std::max(width_, nat_.size())),
+    prec_(precision_ == PRECISION_NONE ? 0 : precision_),
+    prec_scale_(pow10(prec_)),
+    round_scale_(scale_ > prec_scale_ ? scale_ / prec_scale_ : 0)
+  {
+  }
+
+  size_t        get_width()     const { return width_; }
+
+  long          get_scale()     const { return scale_; }
+  int           get_precision() const { return precision_; }
+  int           get_day_size()  const { return day_size_; }
+  char          get_sign()      const { return sign_; }
+  string const& get_nat()       const { return nat_; }
+
+  /*
+   * The maximum number of bytes in one formatted value.  This may exceed the
+   * width if the NaT string contains multibyte characters.
+   */
+  size_t        get_max_bytes() const { return max_bytes_; }
+  bool          is_fixed_bytes() const { return nat_.size() == width_; }
+
+  string operator()(long val) const;
+
+  /*
+   * Formats `val` into `buf`, which must have room for `get_max_bytes()`
+   * bytes.  Returns the end of the formatted value.
+   */
+  char* format(long val, char* buf) const;
+
+private:
+
+  char* format_bad(char* buf) const;
+
+  size_t    const width_;
+  string    const bad_result_;
+
+  long      const scale_;
+  int       const precision_;
+  int       const day_size_;
+  char      const sign_;
+  string    const nat_;
+  size_t    const max_bytes_;
 
   // Intermediate values used in formatting computation.
   int       const prec_;
@@ -0,0 +1,261 @@
+#include <type_traits>
+
+#include <Python.h>
+
+#include "PyNumberStats.hh"
+#include "buffers.hh"
+#include "py.hh"
+
+using namespace py;
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+void
+tp_init(
+  PyNumberStats* self,
+  Tuple* args,
+  Dict* kw_args)
+{
+  static char const* arg_names[] = {"max_precision", "scale", nullptr};
+  Object* max_precision_arg = (Object*) Py_None;
+  Object* scale_arg = (Object*) Py_None;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "|OO", arg_names, &max_precision_arg, &scale_arg);
+
+  int max_precision = -1;
+  if (max_precision_arg != Py_None) {
+    max_precision = max_precision_arg->long_value();
+    if (max_precision < 0)
+      throw ValueError("negative max_precision");
+  }
+  double scale = 0;
+  if (scale_arg != Py_None) {
+    scale = scale_arg->double_value();
+    if (!(scale > 0))
+      throw ValueError("scale not positive");
+  }
+
+  new(self) PyNumberStats;
+  self->max_precision_ = max_precision;
+  self->scale_ = scale;
+}
+
+
+/*
+ * Analyzes a one-dimensional number array, or its rows in `ranges`, and adds
+ * the results.
+ */
+ref<Object> update(PyNumberStats* self, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[] = {"buf", "ranges", "num_threads", nullptr};
+  PyObject* array_obj;
+  PyObject* ranges_obj = Py_None;
+  int num_threads = 0;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "O|Oi", arg_names, &array_obj, &ranges_obj, &num_threads);
+
+  BufferRef buffer(array_obj, PyBUF_STRIDES | PyBUF_FORMAT);
+  if (buffer->ndim != 1)
+    throw TypeError("not a one-dimensional array");
+  if (num_threads < 0)
+    throw ValueError("negative num_threads");
+  auto const ranges = buffers::get_ranges(ranges_obj, buffer->shape[0]);
+
+  fixfmt::NumberStats stats;
+  buffers::with_number_type(buffer, [&](auto const* const dummy) {
+    using TYPE = typename std::decay<decltype(*dummy)>::type;
+    ReleaseGIL release;
+    fixfmt::analyze_number(
+      stats, (TYPE const*) buffer->buf, buffer->strides[0], ranges,
+      self->get_max_precision<TYPE>(), num_threads, self->scale_);
+  });
+  self->stats_.merge(stats);
+  return none_ref();
+}
+
+
+/*
+ * Adds the stats of another array, analyzed the same way.
+ */
+ref<Object> merge(PyNumberStats* self, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[] = {"other", nullptr};
+  PyNumberStats* other;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "O!", arg_names, &PyNumberStats::type_, &other);
+
+  if (other->max_precision_ != self->max_precision_
+      || other->scale_ != self->scale_)
+    throw ValueError("stats analyzed differently");
+  self->stats_.merge(other->stats_);
+  return none_ref();
+}
+
+
+auto methods = Methods<PyNumberStats>()
+  .add<merge>                       ("merge")
+  .add<update>                      ("update")
+;
+
+
+ref<Object> get_digits(PyNumberStats* const self, void* /* closure */)
+{
+  return Long::FromLong(self->stats_.digits);
+}
+
+
+ref<Object> get_has_nan(PyNumberStats* const self, void* /* closure */)
+{
+  return Bool::from(self->stats_.has_nan);
+}
+
+
+ref<Object> get_has_neg_inf(PyNumberStats* const self, void* /* closure */)
+{
+  return Bool::from(self->stats_.has_neg_inf);
+}
+
+
+ref<Object> get_has_pos_inf(PyNumberStats* const self, void* /* closure */)
+{
+  return Bool::from(self->stats_.has_pos_inf);
+}
+
+
+ref<Object> get_integer(PyNumberStats* const self, void* /* closure */)
+{
+  return Bool::from(self->stats_.integer);
+}
+
+
+/*
+ * Returns the min or max as an exact int for integers, since 64-bit integers
+ * don't all fit in a double.
+ */
+ref<Object> get_max(PyNumberStats* const self, void* /* closure */)
+{
+  auto const& stats = self->stats_;
+  if (!stats.integer || stats.num == 0)
+    return Float::from(stats.max);
+  // Any unsigned value exceeds every negative signed one.
+  bool const has_uint = stats.uint_min <= stats.uint_max;
+  if (has_uint
+      && (stats.int_max < 0 || (unsigned long) stats.int_max < stats.uint_max))
+    return Long::from(stats.uint_max);
+  return Long::from(stats.int_max);
+}
+
+
+ref<Object> get_max_precision(PyNumberStats* const self, void* /* closure */)
+{
+  return
+    self->max_precision_ < 0 ? none_ref()
+    : (ref<Object>) Long::FromLong(self->max_precision_);
+}
+
+
+ref<Object> get_min(PyNumberStats* const self, void* /* closure */)
+{
+  auto const& stats = self->stats_;
+  if (!stats.integer || stats.num == 0)
+    return Float::from(stats.min);
+  bool const has_int = stats.int_min <= stats.int_max;
+  if (!has_int
+      || (stats.int_min >= 0 && stats.uint_min < (unsigned long) stats.int_min))
+    return Long::from(stats.uint_min);
+  return Long::from(stats.int_min);
+}
+
+
+ref<Object> get_num(PyNumberStats* const self, void* /* closure */)
+{
+  return Long::FromLong(self->stats_.num);
+}
+
+
+ref<Object> get_precision(PyNumberStats* const self, void* /* closure */)
+{
+  return Long::FromLong(self->stats_.precision);
+}
+
+
+ref<Object> get_scale(PyNumberStats* const self, void* /* closure */)
+{
+  return
+    self->scale_ > 0 ? (ref<Object>) Float::from(self->scale_) : none_ref();
+}
+
+
+auto getsets = GetSets<PyNumberStats>()
+  .add_get<get_digits>              ("digits")
+  .add_get<get_has_nan>             ("has_nan")
+  .add_get<get_has_neg_inf>         ("has_neg_inf")
+  .add_get<get_has_pos_inf>         ("has_pos_inf")
+  .add_get<get_integer>             ("integer")
+  .add_get<get_max>                 ("max")
+  .add_get<get_max_precision>       ("max_precision")
+  .add_get<get_min>                 ("min")
+  .add_get<get_num>                 ("num")
+  .add_get<get_precision>           ("precision")
+  .add_get<get_scale>               ("scale")
+  ;
+
+
+}  // anonymous namespace
+
+
+Type PyNumberStats::type_ = PyTypeObject{
+  PyVarObject_HEAD_INIT(nullptr, 0)
+  (char const*)         "fixfmt._ext.NumberStats",          // tp_name
+  (Py_ssize_t)          sizeof(PyNumberStats),              // tp_basicsize
+  (Py_ssize_t)          0,                                  // tp_itemsize
+  (destructor)          nullptr,                            // tp_dealloc
+  (printfunc)           nullptr,                            // tp_print
+  (getattrfunc)         nullptr,                            // tp_getattr
+  (setattrfunc)         nullptr,                            // tp_setattr
+  (PyAsyncMethods*)     nullptr,                            // tp_as_async
+  (reprfunc)            nullptr,                            // tp_repr
+  (PyNumberMethods*)    nullptr,                            // tp_as_number
+  (PySequenceMethods*)  nullptr,                            // tp_as_sequence
+  (PyMappingMethods*)   nullptr,                            // tp_as_mapping
+  (hashfunc)            nullptr,                            // tp_hash
+  (ternaryfunc)         nullptr,                            // tp_call
+  (reprfunc)            nullptr,                            // tp_str
+  (getattrofunc)        nullptr,                            // tp_getattro
+  (setattrofunc)        nullptr,                            // tp_setattro
+  (PyBufferProcs*)      nullptr,                            // tp_as_buffer
+  (unsigned long)       Py_TPFLAGS_DEFAULT
+                        | Py_TPFLAGS_BASETYPE,              // tp_flags
+  (char const*)         nullptr,                            // tp_doc
+  (traverseproc)        nullptr,                            // tp_traverse
+  (inquiry)             nullptr,                            // tp_clear
+  (richcmpfunc)         nullptr,                            // tp_richcompare
+  (Py_ssize_t)          0,                                  // tp_weaklistoffset
+  (getiterfunc)         nullptr,                            // tp_iter
+  (iternextfunc)        nullptr,                            // tp_iternext
+  (PyMethodDef*)        methods,                            // tp_methods
+  (PyMemberDef*)        nullptr,                            // tp_members
+  (PyGetSetDef*)        getsets,                            // tp_getset
+  (_typeobject*)        nullptr,                            // tp_base
+  (PyObject*)           nullptr,                            // tp_dict
+  (descrgetfunc)        nullptr,                            // tp_descr_get
+  (descrsetfunc)        nullptr,                            // tp_descr_set
+  (Py_ssize_t)          0,                                  // tp_dictoffset
+  (initproc)            wrap<PyNumberStats, tp_init>,       // tp_init
+  (allocfunc)           nullptr,                            // tp_alloc
+  (newfunc)             PyType_GenericNew,                  // tp_new
+  (freefunc)            nullptr,                            // tp_free
+  (inquiry)             nullptr,                            // tp_is_gc
+  (PyObject*)           nullptr,                            // tp_bases
+  (PyObject*)           nullptr,                            // tp_mro
+  (PyObject*)           nullptr,                            // tp_cache
+  (PyObject*)           nullptr,                            // tp_subclasses
+  (PyObject*)           nullptr,                            // tp_weaklist
+  (destructor)          nullptr,                            // tp_del
+  (unsigned int)        0,                                  // tp_version_tag
+  (destructor)          nullptr,                            // tp_finalize
+};
+
+
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <type_traits>
+
+#include <Python.h>
+
+#include "fixfmt.hh"
+#include "py.hh"
+
+//------------------------------------------------------------------------------
+
+/*
+ * Accumulated stats of number arrays, for choosing a formatter.
+ */
+class PyNumberStats
+  : public py::ExtensionType
+{
+public:
+
+  static py::Type type_;
+
+  // Maximum precision to analyze, or -1 to choose by item type.
+  int max_precision_;
+
+  // Factor by which to divide values, or zero for none.
+  double scale_;
+
+  fixfmt::NumberStats stats_;
+
+  // The maximum precision for analyzing values of `TYPE`.
+  template<typename TYPE>
+  int
+  get_max_precision()
+    const
+  {
+    return
+        max_precision_ >= 0 ? max_precision_
+      : std::is_same<TYPE, float>::value ? 8
+      : 16;
+  }
+
+};
+
+
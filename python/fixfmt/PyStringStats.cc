@@ -0,0 +1,165 @@
+#include <algorithm>
+
+#include <Python.h>
+
+#include "PyStringStats.hh"
+#include "buffers.hh"
+#include "py.hh"
+
+using namespace py;
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+void
+tp_init(
+  PyStringStats* self,
+  Tuple* args,
+  Dict* kw_args)
+{
+  static char const* arg_names[] = {"max_size", nullptr};
+  Py_ssize_t max_size;
+  Arg::ParseTupleAndKeywords(args, kw_args, "n", arg_names, &max_size);
+  if (max_size < 0)
+    throw ValueError("negative max_size");
+
+  new(self) PyStringStats;
+  self->max_size_ = max_size;
+}
+
+
+/*
+ * Analyzes a one-dimensional 'U', 'S', or object array, or its rows in
+ * `ranges`, and adds the results.  Once a string of `max_size` is found, only
+ * counts strings.
+ */
+ref<Object> update(PyStringStats* self, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[] = {"buf", "ranges", nullptr};
+  PyObject* array_obj;
+  PyObject* ranges_obj = Py_None;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "O|O", arg_names, &array_obj, &ranges_obj);
+
+  BufferRef buffer(array_obj, PyBUF_STRIDES | PyBUF_FORMAT);
+  if (buffer->ndim != 1)
+    throw TypeError("not a one-dimensional array");
+  auto const kind = buffers::get_string_kind(buffer);
+  auto const ranges = buffers::get_ranges(ranges_obj, buffer->shape[0]);
+
+  long num = 0;
+  for (auto const& range : ranges)
+    num += range.second - range.first;
+  auto const size
+    = self->stats_.size >= self->max_size_ ? self->max_size_
+    : buffers::analyze_strings(buffer, kind, ranges, self->max_size_);
+  self->stats_.update(num, size);
+  return none_ref();
+}
+
+
+/*
+ * Adds the stats of another array, analyzed the same way.
+ */
+ref<Object> merge(PyStringStats* self, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[] = {"other", nullptr};
+  PyStringStats* other;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "O!", arg_names, &PyStringStats::type_, &other);
+
+  if (other->max_size_ != self->max_size_)
+    throw ValueError("stats analyzed differently");
+  self->stats_.merge(other->stats_);
+  return none_ref();
+}
+
+
+auto methods = Methods<PyStringStats>()
+  .add<merge>                       ("merge")
+  .add<update>                      ("update")
+;
+
+
+ref<Object> get_max_size(PyStringStats* const self, void* /* closure */)
+{
+  return Long::FromLong(self->max_size_);
+}
+
+
+ref<Object> get_num(PyStringStats* const self, void* /* closure */)
+{
+  return Long::FromLong(self->stats_.num);
+}
+
+
+ref<Object> get_size(PyStringStats* const self, void* /* closure */)
+{
+  return Long::FromLong(self->stats_.size);
+}
+
+
+auto getsets = GetSets<PyStringStats>()
+  .add_get<get_max_size>            ("max_size")
+  .add_get<get_num>                 ("num")
+  .add_get<get_size>                ("size")
+  ;
+
+
+}  // anonymous namespace
+
+
+Type PyStringStats::type_ = PyTypeObject{
+  PyVarObject_HEAD_INIT(nullptr, 0)
+  (char const*)         "fixfmt._ext.StringStats",          // tp_name
+  (Py_ssize_t)          sizeof(PyStringStats),              // tp_basicsize
+  (Py_ssize_t)          0,                                  // tp_itemsize
+  (destructor)          nullptr,                            // tp_dealloc
+  (printfunc)           nullptr,                            // tp_print
+  (getattrfunc)         nullptr,                            // tp_getattr
+  (setattrfunc)         nullptr,                            // tp_setattr
+  (PyAsyncMethods*)     nullptr,                            // tp_as_async
+  (reprfunc)            nullptr,                            // tp_repr
+  (PyNumberMethods*)    nullptr,                            // tp_as_number
+  (PySequenceMethods*)  nullptr,                            // tp_as_sequence
+  (PyMappingMethods*)   nullptr,                            // tp_as_mapping
+  (hashfunc)            nullptr,                            // tp_hash
+  (ternaryfunc)         nullptr,                            // tp_call
+  (reprfunc)            nullptr,                            // tp_str
+  (getattrofunc)        nullptr,                            // tp_getattro
+  (setattrofunc)        nullptr,                            // tp_setattro
+  (PyBufferProcs*)      nullptr,                            // tp_as_buffer
+  (unsigned long)       Py_TPFLAGS_DEFAULT
+                        | Py_TPFLAGS_BASETYPE,              // tp_flags
+  (char const*)         nullptr,                            // tp_doc
+  (traverseproc)        nullptr,                            // tp_traverse
+  (inquiry)             nullptr,                            // tp_clear
+  (richcmpfunc)         nullptr,                            // tp_richcompare
+  (Py_ssize_t)          0,                                  // tp_weaklistoffset
+  (getiterfunc)         nullptr,                            // tp_iter
+  (iternextfunc)        nullptr,                            // tp_iternext
+  (PyMethodDef*)        methods,                            // tp_methods
+  (PyMemberDef*)        nullptr,                            // tp_members
+  (PyGetSetDef*)        getsets,                            // tp_getset
+  (_typeobject*)        nullptr,                            // tp_base
+  (PyObject*)           nullptr,                            // tp_dict
+  (descrgetfunc)        nullptr,                            // tp_descr_get
+  (descrsetfunc)        nullptr,                            // tp_descr_set
+  (Py_ssize_t)          0,                                  // tp_dictoffset
+  (initproc)            wrap<PyStringStats, tp_init>,       // tp_init
+  (allocfunc)           nullptr,                            // tp_alloc
+  (newfunc)             PyType_GenericNew,                  // tp_new
+  (freefunc)            nullptr,                            // tp_free
+  (inquiry)             nullptr,                            // tp_is_gc
+  (PyObject*)           nullptr,                            // tp_bases
+  (PyObject*)           nullptr,                            // tp_mro
+  (PyObject*)           nullptr,                            // tp_cache
+  (PyObject*)           nullptr,                            // tp_subclasses
+  (PyObject*)           nullptr,                            // tp_weaklist
+  (destructor)          nullptr,                            // tp_del
+  (unsigned int)        0,                                  // tp_version_tag
+  (destructor)          nullptr,                            // tp_finalize
+};
+
+
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Python.h>
+
+#include "fixfmt.hh"
+#include "py.hh"
+
+//------------------------------------------------------------------------------
+
+/*
+ * Accumulated stats of string arrays, for choosing a formatter.
+ */
+class PyStringStats
+  : public py::ExtensionType
+{
+public:
+
+  static py::Type type_;
+
+  // Greatest length of interest.
+  size_t max_size_;
+
+  fixfmt::StringStats stats_;
+
+};
+
+
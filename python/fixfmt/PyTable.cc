@@ -1,12 +1,19 @@
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 
 #include "PyBool.hh"
 #include "PyNumber.hh"
 #include "PyString.hh"
 #include "PyTable.hh"
+#include "PyTickDuration.hh"
 #include "PyTickTime.hh"
+#include "buffers.hh"
 
 using namespace py;
 using std::unique_ptr;
@@ -22,6 +29,37 @@ void tp_dealloc(PyTable* self)
 }
 
 
+/**
+ * Marks the table as being rendered, while in scope.  Must be constructed, and
+ * destroyed, with the GIL held.
+ */
+class Rendering
+{
+public:
+
+  Rendering(PyTable* const self) : self_(self) { ++self_->num_renders_; }
+  ~Rendering() { --self_->num_renders_; }
+
+  Rendering(Rendering const&) = delete;
+  Rendering& operator=(Rendering const&) = delete;
+
+private:
+
+  PyTable* const self_;
+
+};
+
+
+/**
+ * Raises if the table is being rendered, and so may not change.
+ */
+void check_not_rendering(PyTable const* const self)
+{
+  if (self->num_renders_ > 0)
+    throw RuntimeError("can't change a table while it's being rendered");
+}
+
+
 int tp_init(PyTable* self, Tuple* args, Dict* kw_args)
 {
   // No arguments.
@@ -45,7 +83,75 @@ ref<Object> tp_call(PyTable* self, Tuple* args, Dict* kw_args)
   if (index >= self->table_->get_length())
     throw IndexError("index larger than length");
 
-  return Unicode::from((*self->table_)(index));
+  std::string buf;
+  {
+    Rendering rendering(self);
+    ReleaseGIL release(!self->needs_python_);
+    self->table_->render_row(index, buf);
+  }
+  return Unicode::from(buf);
+}
+
+
+/**
+ * Renders rows 'begin' up to 'end', separated by newlines.
+ *
+ * Renders on up to 'num_threads' threads, or one per CPU if zero.  A table
+ * with Python object columns always renders on the calling thread, since it
+ * needs the GIL.
+ *
+ * If 'lines' is true, returns a list of the rows instead, split at row
+ * boundaries rather than at newlines, which cells may contain.  These render
+ * on the calling thread.
+ */
+ref<Object> render_rows(PyTable* self, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[]
+    = {"begin", "end", "num_threads", "lines", nullptr};
+  long begin;
+  long end;
+  int num_threads = 1;
+  int lines = false;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "ll|ip", arg_names, &begin, &end, &num_threads, &lines);
+
+  if (begin < 0)
+    throw IndexError("negative begin");
+  if (end > self->table_->get_length())
+    throw IndexError("end larger than length");
+  if (num_threads < 0)
+    throw ValueError("negative num_threads");
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  std::string buf;
+  if (lines) {
+    std::vector<size_t> ends;
+    {
+      Rendering rendering(self);
+      ReleaseGIL release(!self->needs_python_);
+      self->table_->render_rows(begin, end, buf, &ends);
+    }
+    auto rows = List::New(ends.size());
+    size_t start = 0;
+    for (size_t r = 0; r < ends.size(); ++r) {
+      rows->initialize(
+        r, Unicode::FromStringAndSize(&buf[start], ends[r] - start));
+      // Skip the newline.
+      start = ends[r] + 1;
+    }
+    return std::move(rows);
+  }
+
+  {
+    Rendering rendering(self);
+    ReleaseGIL release(!self->needs_python_);
+    if (num_threads == 1 || self->needs_python_)
+      self->table_->render_rows(begin, end, buf);
+    else
+      self->table_->render_parallel(begin, end, buf, num_threads);
+  }
+  return Unicode::from(buf);
 }
 
 
@@ -77,8 +183,10 @@ ref<Object> add_string(PyTable* self, Tuple* args, Dict* kw_args)
 
   if (str_arg != Py_None) {
     std::string const str{str_arg->Str()->as_utf8_string()};
-    if (str.length() > 0)
+    if (str.length() > 0) {
+      check_not_rendering(self);
       self->table_->add_string(std::move(str));
+    }
   }
 
   return none_ref();
@@ -88,9 +196,9 @@ ref<Object> add_string(PyTable* self, Tuple* args, Dict* kw_args)
 /**
  * Template method for adding a column to the table.
  *
- * 'buf' is a 'bytes' object containing contiguous values of type 'TYPE', e.g.
- * 'int' or 'double'.  'PYFMT' is a Python object that wraps a formatter for
- * 'TYPE' values.
+ * 'buf' is a one-dimensional buffer of values of type 'TYPE', e.g. 'int' or
+ * 'double'; the values needn't be contiguous.  'PYFMT' is a Python object that
+ * wraps a formatter for 'TYPE' values.
  */
 template<typename TYPE, typename PYFMT>
 ref<Object> add_column(PyTable* self, Tuple* args, Dict* kw_args)
@@ -104,18 +212,19 @@ ref<Object> add_column(PyTable* self, Tuple* args, Dict* kw_args)
       &array, &PYFMT::type_, &format);
 
   // Validate args.
-  BufferRef buffer(array, PyBUF_ND);
+  BufferRef buffer(array, PyBUF_STRIDES);
   if (buffer->ndim != 1)
     throw TypeError("not a one-dimensional array");
   if (buffer->itemsize != sizeof(TYPE))
     throw TypeError("wrong itemsize");
 
   // Add the column.
-  using Column = fixfmt::ColumnImpl<TYPE, typename PYFMT::Formatter>;
-  self->table_->add_column(std::make_unique<Column>(
-    reinterpret_cast<TYPE*>(buffer->buf), 
+  check_not_rendering(self);
+  self->table_->add_column(
+    reinterpret_cast<TYPE const*>(buffer->buf),
     buffer->shape[0], 
-    *format->fmt_));
+    *format->fmt_,
+    buffer->strides[0]);
   // Hold on to the buffer ref.
   self->buffers_.push_back(std::move(buffer));
 
@@ -124,173 +233,273 @@ ref<Object> add_column(PyTable* self, Tuple* args, Dict* kw_args)
 
 
 /**
- * Column of fixed-size UTF-8 strings.
+ * Adds a column of 'length' bit-packed bools, as from 'np.packbits()' with
+ * 'bitorder="little"'.  Value 'i' is bit 'bit_offset + i', counting from the
+ * least significant bit of each byte.
  */
-class UTF8Column
-  : public fixfmt::Column
+ref<Object> add_bool_bits(PyTable* self, Tuple* args, Dict* kw_args)
 {
-public:
-
-  UTF8Column(
-    size_t const itemsize, char* const values, long const length,
-    fixfmt::String format)
-  : itemsize_(itemsize),
-    values_(values),
-    length_(length),
-    format_(std::move(format))
-  {
-  }
-
-  virtual ~UTF8Column() override {}
-
-  virtual int get_width() const override { return format_.get_width(); }
-
-  virtual long get_length() const override { return length_; }
-
-  virtual std::string operator()(long const index) const override {
-    // Skip NUL padding on the right.
-    auto const ptr = values_ + index * itemsize_;
-    return format_(std::string(ptr, strnlen(ptr, itemsize_)));
-  }
+  // Parse args.
+  static char const* arg_names[]
+    = {"buf", "length", "format", "bit_offset", nullptr};
+  PyObject* array;
+  long length;
+  PyBool* format;
+  long bit_offset = 0;
+  Arg::ParseTupleAndKeywords(
+      args, kw_args, "OlO!|l", arg_names,
+      &array, &length, &PyBool::type_, &format, &bit_offset);
 
-private:
+  // Validate args.
+  BufferRef buffer(array, PyBUF_SIMPLE);
+  if (length < 0 || bit_offset < 0)
+    throw ValueError("negative length or offset");
+  if (buffer->len * 8 < bit_offset + length)
+    throw ValueError("buffer too short");
 
-  size_t const itemsize_;
-  char* const values_;
-  long const length_;
-  fixfmt::String const format_;
+  // Add the column.
+  check_not_rendering(self);
+  self->table_->add_bool_bits(
+    static_cast<uint8_t const*>(buffer->buf), bit_offset, length,
+    *format->fmt_);
+  // Hold on to the buffer ref.
+  self->buffers_.push_back(std::move(buffer));
 
-};
+  return none_ref();
+}
 
 
 /**
- * Column of fixed-size UCS-32 strings.
+ * Column of Python object pointers, with an object first converted with 'str()'
+ * and then formatted as a string.
+ *
+ * The common types are converted without calling 'str()': 'str' objects are
+ * read in place, 'int' and 'float' objects are converted directly, and 'None'
+ * is shown as a preformatted 'none' string.
+ *
+ * Columns often refer to the same objects many times.  Formatted cells of
+ * 'str', 'int', and 'float' objects, which are immutable, are cached by object
+ * identity, for up to 'cache_size' objects.  The cache holds a reference to
+ * each object, so that its address can't be reused.  If the cache fills up
+ * with mostly misses, it's dropped.
  */
-class UCS32Column
+class StrObjectColumn
   : public fixfmt::Column
 {
 public:
 
-  UCS32Column(
-    size_t const itemsize, char* const values, long const length,
-    fixfmt::String format)
-  : itemsize_(itemsize),
-    values_(values),
+  StrObjectColumn(
+    Object* const* values, long const length, fixfmt::String format,
+    long const stride=sizeof(Object*), std::string const& none="None",
+    size_t const cache_size=0, ObjectCacheStats* const stats=nullptr)
+  : values_(reinterpret_cast<char const*>(values)),
     length_(length),
-    format_(std::move(format))
+    format_(std::move(format)),
+    stride_(stride),
+    none_(format_(none)),
+    cache_size_(cache_size),
+    table_stats_(stats)
   {
-    assert(itemsize % 4 == 0);
   }
 
-  virtual ~UCS32Column() override {}
+  virtual ~StrObjectColumn() override {}
 
   virtual int get_width() const override { return format_.get_width(); }
 
   virtual long get_length() const override { return length_; }
 
-  virtual std::string operator()(long const index) const override {
-    // Encode UTF-8 from Unicode code points.
-    // FIXME: Is this always right?
-    auto const ptr = reinterpret_cast<unsigned*>(values_ + index * itemsize_);
-    std::string s;
-    for (size_t i = 0; i < itemsize_ / 4; i++) {
-      auto const c = ptr[i];
-      if (c == 0)
-        // Skip trailing NULs.
-        break;
-      else if (c < 0x80)
-        s.push_back(c);
-      else if (c < 0x800) {
-        s.push_back(192 | ( c >> 6       ));
-        s.push_back(128 | ( c        & 63));
-      }
-      else if (c < 0x10000) {
-        s.push_back(224 | ( c >> 12      ));
-        s.push_back(128 | ((c >>  6) & 63));
-        s.push_back(128 | ( c        & 63));
-      }
-      else {
-        s.push_back(240 | ( c >> 18      ));
-        s.push_back(128 | ((c >> 12) & 63));
-        s.push_back(128 | ((c >>  6) & 63));
-        s.push_back(128 | ( c        & 63));
-      }
-    }
-    return format_(s);
+  virtual std::string operator()(long const index) const override
+  {
+    auto const obj = get(index);
+    if (obj == Py_None)
+      return none_;
+    else if (cache_size_ > 0 && is_cacheable(obj))
+      return get_cached(obj);
+    else
+      return format_(to_string(obj));
   }
 
-private:
-
-  size_t const itemsize_;
-  char* const values_;
-  long const length_;
-  fixfmt::String const format_;
-
-};
+  virtual size_t get_max_bytes() const override 
+    { return std::max(format_.get_max_bytes(), none_.size()); }
 
+  virtual char* format(long const index, char* const buf) const override
+  {
+    auto const obj = get(index);
+    if (obj == Py_None) {
+      memcpy(buf, none_.data(), none_.size());
+      return buf + none_.size();
+    }
+    else if (cache_size_ > 0 && is_cacheable(obj)) {
+      auto const cell = get_cached(obj);
+      // Like the formatter, don't write a cell longer than the bound.
+      if (cell.size() <= format_.get_max_bytes())
+        memcpy(buf, cell.data(), cell.size());
+      return buf + cell.size();
+    }
+    else
+      return format_.format(to_string(obj), buf);
+  }
 
-/**
- * Column of Python object pointers, with an object first converted with 'str()'
- * and then formatted as a string.
- */
-class StrObjectColumn
-  : public fixfmt::Column
-{
-public:
+private:
 
-  StrObjectColumn(Object** values, long const length, fixfmt::String format)
-  : values_(values),
-    length_(length),
-    format_(std::move(format))
+  Object* get(long const index) const
   {
+    return *reinterpret_cast<Object* const*>(values_ + index * stride_);
   }
 
-  virtual ~StrObjectColumn() override {}
-
-  virtual int get_width() const override { return format_.get_width(); }
+  static bool is_cacheable(Object* const obj)
+  {
+    return
+      PyUnicode_CheckExact(obj) || PyLong_CheckExact(obj)
+      || PyFloat_CheckExact(obj);
+  }
 
-  virtual long get_length() const override { return length_; }
+  /**
+   * Returns the formatted cell for 'obj', from or into the cache.  Returns a
+   * copy, so that concurrent renders share no buffer.
+   */
+  std::string get_cached(Object* const obj) const
+  {
+    auto const i = cache_.find(obj);
+    bool const hit = i != cache_.end();
+    ++(hit ? stats_.hits : stats_.misses);
+    if (table_stats_ != nullptr)
+      ++(hit ? table_stats_->hits : table_stats_->misses);
+    if (hit)
+      return i->second.cell;
+
+    if (cache_.size() >= cache_size_) {
+      // Full.  Unless it has paid off, drop it.
+      if (stats_.hits < stats_.misses) {
+        cache_.clear();
+        cache_size_ = 0;
+      }
+      return format_(to_string(obj));
+    }
+    auto const entry = cache_.emplace(
+      obj, CacheEntry{ref<Object>::of(obj), format_(to_string(obj))});
+    return entry.first->second.cell;
+  }
 
-  virtual std::string operator()(long const index) const override
+  /**
+   * Returns 'str(obj)' as UTF-8.
+   */
+  static std::string to_string(Object* const obj)
   {
+    if (PyUnicode_CheckExact(obj)) {
+      if (PyUnicode_IS_COMPACT_ASCII(obj))
+        // ASCII is already UTF-8.
+        return std::string(
+          static_cast<char const*>(PyUnicode_DATA(obj)),
+          PyUnicode_GET_LENGTH(obj));
+      Py_ssize_t length;
+      auto const utf8 = PyUnicode_AsUTF8AndSize(obj, &length);
+      if (utf8 != nullptr)
+        return std::string(utf8, length);
+      // Not encodable; let 'str()' raise.
+      PyErr_Clear();
+    }
+    else if (PyLong_CheckExact(obj)) {
+      int overflow;
+      auto const val = PyLong_AsLongAndOverflow(obj, &overflow);
+      if (overflow == 0)
+        return std::to_string(val);
+    }
+    else if (PyFloat_CheckExact(obj)) {
+      // The shortest repr, as 'str()' produces.
+      auto const str = PyOS_double_to_string(
+        PyFloat_AS_DOUBLE(obj), 'r', 0, Py_DTSF_ADD_DOT_0, nullptr);
+      if (str != nullptr) {
+        std::string result(str);
+        PyMem_Free(str);
+        return result;
+      }
+      PyErr_Clear();
+    }
+
     // Convert (or cast) to string.
-    auto str = values_[index]->Str();
-    // Format the string.
-    return format_(str->as_utf8_string());
+    return obj->Str()->as_utf8_string();
   }
 
-private:
-
-  Object** const values_;
+  char const* const values_;
   long const length_;
   fixfmt::String const format_;
+  long const stride_;
+  // The formatted 'None' string.
+  std::string const none_;
+
+  struct CacheEntry
+  {
+    // Keeps the object alive.
+    ref<Object> obj;
+    std::string cell;
+  };
+
+  // Formatted cells, keyed by object identity.
+  mutable std::unordered_map<PyObject*, CacheEntry> cache_;
+  mutable size_t cache_size_;
+  // Lookups in this column's cache, and in all the table's.
+  mutable ObjectCacheStats stats_;
+  ObjectCacheStats* const table_stats_;
 
 };
 
 
-ref<Object> add_tick_time_column(PyTable* self, Tuple* args, Dict* kw_args)
+/**
+ * Returns a buffer of 64-bit ticks.
+ *
+ * numpy doesn't export datetime64 and timedelta64 arrays through the buffer
+ * protocol, so for these we take the buffer of an int64 view instead.  The
+ * view shares the array's data, so nothing is copied.
+ */
+BufferRef
+get_tick_buffer(
+  Object* const array)
+{
+  Py_buffer buffer;
+  if (PyObject_GetBuffer(array, &buffer, PyBUF_STRIDES) == 0)
+    return BufferRef(std::move(buffer));
+
+  Exception::Clear();
+  auto const view = array->CallMethodObjArgs(
+    "view", Unicode::from("int64"), false);
+  if (view == nullptr)
+    throw TypeError("not a buffer or datetime64/timedelta64 array");
+  return BufferRef(view, PyBUF_STRIDES);
+}
+
+
+/**
+ * Template method for adding a column of ticks to the table.
+ *
+ * 'buf' is an int64, datetime64, or timedelta64 array.  The tick scale is
+ * taken from the formatter, not the array's dtype.
+ */
+template<typename PYFMT>
+ref<Object> add_tick_column(PyTable* self, Tuple* args, Dict* kw_args)
 {
   // Parse args.
   static char const* arg_names[] = { "buf", "format", nullptr };
-  PyObject* array;
-  PyTickTime* format;
+  Object* array;
+  PYFMT* format;
   Arg::ParseTupleAndKeywords(
     args, kw_args, "OO!", arg_names,
-    &array, &PyTickTime::type_, &format);
+    &array, &PYFMT::type_, &format);
 
   // Validate args.
-  BufferRef buffer(array, PyBUF_ND);
+  auto buffer = get_tick_buffer(array);
   if (buffer->ndim != 1)
     throw TypeError("not a one-dimensional array");
   if (buffer->itemsize != sizeof(long))
     throw TypeError("wrong itemsize");
 
   // Add the column.
-  using Column = fixfmt::ColumnImpl<long, typename PyTickTime::Formatter>;
-  self->table_->add_column(std::make_unique<Column>(
+  check_not_rendering(self);
+  self->table_->add_column(
     reinterpret_cast<long const*>(buffer->buf),
     buffer->shape[0], 
-    *format->fmt_));
+    *format->fmt_,
+    buffer->strides[0]);
   // Hold on to the buffer ref.
   self->buffers_.emplace_back(std::move(buffer));
 
@@ -310,16 +519,18 @@ ref<Object> add_utf8_column(PyTable* self, Tuple* args, Dict* kw_args)
     &itemsize, &array, &PyString::type_, &format);
 
   // Validate args.
-  BufferRef buffer(array, PyBUF_ND);
+  BufferRef buffer(array, PyBUF_STRIDES);
   if (buffer->ndim != 1)
     throw TypeError("not a one-dimensional array");
 
   // Add the column.
-  self->table_->add_column(std::make_unique<UTF8Column>(
-    itemsize,            
-    reinterpret_cast<char*>(buffer->buf),
+  check_not_rendering(self);
+  self->table_->add_utf8(
+    reinterpret_cast<char const*>(buffer->buf),
+    itemsize,
+    buffer->strides[0],
     buffer->shape[0], 
-    *format->fmt_));
+    *format->fmt_);
   // Hold on to the buffer ref.
   self->buffers_.emplace_back(std::move(buffer));
 
@@ -339,16 +550,18 @@ ref<Object> add_ucs32_column(PyTable* self, Tuple* args, Dict* kw_args)
     &itemsize, &array, &PyString::type_, &format);
 
   // Validate args.
-  BufferRef buffer(array, PyBUF_ND);
+  BufferRef buffer(array, PyBUF_STRIDES);
   if (buffer->ndim != 1)
     throw TypeError("not a one-dimensional array");
 
   // Add the column.
-  self->table_->add_column(std::make_unique<UCS32Column>(
-    itemsize,            
-    reinterpret_cast<char*>(buffer->buf),
+  check_not_rendering(self);
+  self->table_->add_ucs32(
+    reinterpret_cast<char const*>(buffer->buf),
+    itemsize,
+    buffer->strides[0],
     buffer->shape[0], 
-    *format->fmt_));
+    *format->fmt_);
   // Hold on to the buffer ref.
   self->buffers_.emplace_back(std::move(buffer));
 
@@ -356,39 +569,312 @@ ref<Object> add_ucs32_column(PyTable* self, Tuple* args, Dict* kw_args)
 }
 
 
+/**
+ * Adds a column of Python objects, each shown as its 'str()'.  'None' shows as
+ * 'none'.  Formatted cells of up to 'cache_size' distinct objects are cached;
+ * zero disables the cache.
+ */
 ref<Object> add_str_object_column(PyTable* self, Tuple* args, Dict* kw_args)
 {
   // Parse args.
-  static char const* arg_names[] = {"buf", "format", nullptr};
+  static char const* arg_names[]
+    = {"buf", "format", "none", "cache_size", nullptr};
   PyObject* array;
   PyString* format;
+  char const* none = "None";
+  Py_ssize_t cache_size = 4096;
   Arg::ParseTupleAndKeywords(
-      args, kw_args, "OO!", arg_names,
-      &array, &PyString::type_, &format);
+      args, kw_args, "OO!|sn", arg_names,
+      &array, &PyString::type_, &format, &none, &cache_size);
   
   // Validate args.
-  BufferRef buffer(array, PyBUF_ND);
+  BufferRef buffer(array, PyBUF_STRIDES);
   if (buffer->ndim != 1)
     throw TypeError("not a one-dimensional array");
   if (buffer->itemsize != sizeof(Object*))
     throw TypeError("wrong itemsize");
+  if (cache_size < 0)
+    throw ValueError("negative cache_size");
 
   // Add the column.
+  check_not_rendering(self);
   self->table_->add_column(std::make_unique<StrObjectColumn>(
-    reinterpret_cast<Object**>(buffer->buf),
+    reinterpret_cast<Object* const*>(buffer->buf),
     buffer->shape[0], 
-    *format->fmt_));
+    *format->fmt_,
+    buffer->strides[0],
+    none,
+    cache_size,
+    &self->object_cache_stats_));
   // Hold on to the buffer ref.
   self->buffers_.emplace_back(std::move(buffer));
+  // Formatting calls 'str()'.
+  self->needs_python_ = true;
+
+  return none_ref();
+}
+
+
+/**
+ * Template method for adding an indexed column of type 'IDXTYPE' codes.
+ */
+template<typename IDXTYPE>
+void
+add_indexed_column(
+  PyTable* const self,
+  BufferRef& codes,
+  fixfmt::Table const& categories,
+  char const* const null)
+{
+  self->table_->add_column(std::make_unique<fixfmt::IndexedColumn<IDXTYPE>>(
+    reinterpret_cast<IDXTYPE const*>(codes->buf),
+    codes->shape[0],
+    categories,
+    null,
+    codes->strides[0]));
+  // Hold on to the buffer ref.
+  self->buffers_.emplace_back(std::move(codes));
+}
+
+
+/**
+ * Adds a column of categorical values.
+ *
+ * 'codes' is an array of signed integer codes.  'categories' is a table
+ * containing a single column of category values, each formatted once.  A
+ * negative code shows as 'null', by default a blank.
+ */
+ref<Object> add_indexed(PyTable* self, Tuple* args, Dict* kw_args)
+{
+  // Parse args.
+  static char const* arg_names[] = {"codes", "categories", "null", nullptr};
+  PyObject* array;
+  PyTable* categories;
+  char const* null = "";
+  Arg::ParseTupleAndKeywords(
+      args, kw_args, "OO!|s", arg_names,
+      &array, &PyTable::type_, &categories, &null);
+
+  // Validate args.
+  BufferRef codes(array, PyBUF_STRIDES);
+  if (codes->ndim != 1)
+    throw TypeError("not a one-dimensional array");
+  if (categories->table_->get_length() == fixfmt::MAX_INDEX)
+    throw ValueError("categories table has no columns");
+
+  // Add the column.  Formats the categories, so they mustn't change either.
+  check_not_rendering(self);
+  Rendering rendering(categories);
+  auto const& cats = *categories->table_;
+  switch (codes->itemsize) {
+  case 1: add_indexed_column<int8_t>(self, codes, cats, null); break;
+  case 2: add_indexed_column<int16_t>(self, codes, cats, null); break;
+  case 4: add_indexed_column<int32_t>(self, codes, cats, null); break;
+  case 8: add_indexed_column<int64_t>(self, codes, cats, null); break;
+  default: throw TypeError("wrong itemsize");
+  }
+
+  return none_ref();
+}
+
+
+/**
+ * Template method for adding a run column of type 'TYPE' values.
+ */
+template<typename TYPE, typename PYFMT>
+void
+add_run_column(
+  PyTable* const self,
+  BufferRef& values,
+  BufferRef* const run_lengths,
+  Object* const format,
+  int const repeat,
+  char const* const ditto)
+{
+  if (!PyObject_TypeCheck(format, &PYFMT::type_))
+    throw TypeError("wrong formatter for values");
+  auto const& fmt = *((PYFMT*) format)->fmt_;
+  using Col = fixfmt::RunColumn<TYPE, typename std::decay<decltype(fmt)>::type>;
+  auto const vals = reinterpret_cast<TYPE const*>(values->buf);
+  auto const rep = (typename Col::Repeat) repeat;
+
+  if (run_lengths == nullptr)
+    self->table_->add_column(std::make_unique<Col>(
+      vals, values->shape[0], fmt, rep, ditto, values->strides[0]));
+  else {
+    self->table_->add_column(std::make_unique<Col>(
+      vals, reinterpret_cast<long const*>((*run_lengths)->buf),
+      values->shape[0], fmt, rep, ditto, values->strides[0]));
+    self->buffers_.emplace_back(std::move(*run_lengths));
+  }
+  // Hold on to the buffer ref.
+  self->buffers_.emplace_back(std::move(values));
+}
+
+
+/**
+ * Adds a column of numbers or bools in runs of equal values.  Each run is
+ * formatted once.
+ *
+ * Without 'run_lengths', 'buf' holds one value per row, and a run is a stretch
+ * of equal consecutive values.  With 'run_lengths', an int64 array, value 'r'
+ * of 'buf' is repeated 'run_lengths[r]' times.
+ *
+ * 'repeat' is what rows after the first of each run show: "show" for the value,
+ * "blank" for a blank, or "ditto" for the 'ditto' marker.
+ */
+ref<Object> add_runs(PyTable* self, Tuple* args, Dict* kw_args)
+{
+  // Parse args.
+  static char const* arg_names[]
+    = {"buf", "format", "run_lengths", "repeat", "ditto", nullptr};
+  PyObject* array;
+  Object* format;
+  PyObject* lengths_array = Py_None;
+  char const* repeat_name = "show";
+  char const* ditto = "\"";
+  Arg::ParseTupleAndKeywords(
+      args, kw_args, "OO|Oss", arg_names,
+      &array, &format, &lengths_array, &repeat_name, &ditto);
+
+  // Validate args.
+  int repeat;
+  if (strcmp(repeat_name, "show") == 0)
+    repeat = 0;
+  else if (strcmp(repeat_name, "blank") == 0)
+    repeat = 1;
+  else if (strcmp(repeat_name, "ditto") == 0)
+    repeat = 2;
+  else
+    throw ValueError("repeat must be \"show\", \"blank\", or \"ditto\"");
+
+  BufferRef buffer(array, PyBUF_STRIDES | PyBUF_FORMAT);
+  if (buffer->ndim != 1)
+    throw TypeError("not a one-dimensional array");
+
+  unique_ptr<BufferRef> lengths;
+  if (lengths_array != Py_None) {
+    lengths = std::make_unique<BufferRef>(
+      lengths_array, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT);
+    auto const type = buffers::get_type(*lengths);
+    if ((*lengths)->ndim != 1 || (type != 'l' && type != 'q')
+        || (*lengths)->itemsize != sizeof(long))
+      throw TypeError("run_lengths not a one-dimensional int64 array");
+    if ((*lengths)->shape[0] != buffer->shape[0])
+      throw ValueError("run_lengths length doesn't match values");
+    auto const lens = static_cast<long const*>((*lengths)->buf);
+    if (std::any_of(
+          lens, lens + (*lengths)->shape[0], [](long l) { return l < 0; }))
+      throw ValueError("negative run length");
+  }
+
+  check_not_rendering(self);
+
+  // Dispatch on the buffer's item type.
+  if (buffers::get_type(buffer) == '?') {
+    if (buffer->itemsize != sizeof(bool))
+      throw TypeError("wrong itemsize");
+    add_run_column<bool, PyBool>(
+      self, buffer, lengths.get(), format, repeat, ditto);
+  }
+  else
+    buffers::with_number_type(buffer, [&](auto const* const dummy) {
+      using TYPE = typename std::decay<decltype(*dummy)>::type;
+      add_run_column<TYPE, PyNumber>(
+        self, buffer, lengths.get(), format, repeat, ditto);
+    });
+
+  return none_ref();
+}
+
+
+/**
+ * Masks entries of the most recently added column.
+ *
+ * 'valid' is a validity bitmap, with the bit for entry 'i' at bit 'offset + i',
+ * least significant bit first.  Entries whose bits are clear show as 'null'.
+ */
+ref<Object> set_valid(PyTable* self, Tuple* args, Dict* kw_args)
+{
+  // Parse args.
+  static char const* arg_names[] = {"valid", "null", "offset", nullptr};
+  PyObject* array;
+  char const* null = "";
+  long offset = 0;
+  Arg::ParseTupleAndKeywords(
+      args, kw_args, "O|sl", arg_names, &array, &null, &offset);
+
+  // Validate args.
+  auto const length = self->table_->get_length();
+  if (length == fixfmt::MAX_INDEX)
+    throw ValueError("table has no columns");
+  if (!self->table_->ends_with_column())
+    throw ValueError("last added a string, not a column");
+  BufferRef buffer(array, PyBUF_SIMPLE);
+  if (offset < 0 || buffer->len * 8 < offset + length)
+    throw ValueError("validity bitmap too short");
+
+  check_not_rendering(self);
+  self->table_->set_valid(
+    static_cast<uint8_t const*>(buffer->buf), offset, null);
+  // Hold on to the buffer ref.
+  self->buffers_.emplace_back(std::move(buffer));
+
+  return none_ref();
+}
+
+
+/**
+ * Adds a column over an Arrow array, without copying it.
+ *
+ * 'array' is any object that implements the Arrow PyCapsule interface, i.e. an
+ * '__arrow_c_array__()' method.  'format' must suit the array's type, or its
+ * dictionary's value type.  Null entries show as 'null'.
+ */
+ref<Object> add_arrow(PyTable* self, Tuple* args, Dict* kw_args)
+{
+  // Parse args.
+  static char const* arg_names[] = {"array", "format", "null", nullptr};
+  Object* array;
+  Object* format;
+  char const* null = "";
+  Arg::ParseTupleAndKeywords(
+      args, kw_args, "OO|s", arg_names, &array, &format, &null);
+
+  auto exported = buffers::export_arrow(array);
+
+  // Add the column, with the formatter's concrete type.
+  check_not_rendering(self);
+  auto const add = [&](auto const* const fmt) {
+    fixfmt::add_arrow_column(
+      *self->table_, *exported.schema, *exported.array, *fmt->fmt_, null);
+  };
+  if (PyObject_TypeCheck(format, &PyNumber::type_))
+    add((PyNumber*) format);
+  else if (PyObject_TypeCheck(format, &PyBool::type_))
+    add((PyBool*) format);
+  else if (PyObject_TypeCheck(format, &PyString::type_))
+    add((PyString*) format);
+  else if (PyObject_TypeCheck(format, &PyTickTime::type_))
+    add((PyTickTime*) format);
+  else if (PyObject_TypeCheck(format, &PyTickDuration::type_))
+    add((PyTickDuration*) format);
+  else
+    throw TypeError("not a formatter");
+
+  // Hold on to the capsules, and with them the Arrow buffers.
+  self->objects_.emplace_back(std::move(exported.capsules));
 
   return none_ref();
 }
 
 
 auto methods = Methods<PyTable>()
+  .add<render_rows>                             ("render_rows")
   .add<add_string>                              ("add_string")
   .add<add_column<bool,             PyBool>>    ("add_bool")
-  .add<add_column<char,             PyNumber>>  ("add_int8")
+  .add<add_bool_bits>                           ("add_bool_bits")
+  .add<add_column<signed char,      PyNumber>>  ("add_int8")
   .add<add_column<short,            PyNumber>>  ("add_int16")
   .add<add_column<int,              PyNumber>>  ("add_int32")
   .add<add_column<long,             PyNumber>>  ("add_int64")
@@ -398,10 +884,15 @@ auto methods = Methods<PyTable>()
   .add<add_column<unsigned long,    PyNumber>>  ("add_uint64")
   .add<add_column<float,            PyNumber>>  ("add_float32")
   .add<add_column<double,           PyNumber>>  ("add_float64")
-  .add<add_tick_time_column>                    ("add_tick_time")
+  .add<add_tick_column<PyTickTime>>             ("add_tick_time")
+  .add<add_tick_column<PyTickDuration>>         ("add_tick_duration")
   .add<add_utf8_column>                         ("add_utf8")
   .add<add_ucs32_column>                        ("add_ucs32")
   .add<add_str_object_column>                   ("add_str_object")
+  .add<add_indexed>                             ("add_indexed")
+  .add<add_runs>                                ("add_runs")
+  .add<add_arrow>                               ("add_arrow")
+  .add<set_valid>                               ("set_valid")
 ;
 
 
@@ -411,6 +902,28 @@ ref<Object> get_length(PyTable* const self, void* /* closure */)
 }
 
 
+ref<Object> get_needs_python(PyTable* const self, void* /* closure */)
+{
+  return Bool::from(self->needs_python_);
+}
+
+
+ref<Object> get_object_cache_stats(PyTable* const self, void* /* closure */)
+{
+  auto const& stats = self->object_cache_stats_;
+  return Tuple::builder
+    << Long::FromLong(stats.hits) << Long::FromLong(stats.misses);
+}
+
+
+ref<Object> get_cell_cache_stats(PyTable* const self, void* /* closure */)
+{
+  auto const stats = self->table_->get_cell_cache_stats();
+  return Tuple::builder
+    << Long::FromLong(stats.hits) << Long::FromLong(stats.misses);
+}
+
+
 ref<Object> get_width(PyTable* const self, void* /* closure */)
 {
   return Long::FromLong(self->table_->get_width());
@@ -418,8 +931,11 @@ ref<Object> get_width(PyTable* const self, void* /* closure */)
 
 
 auto getsets = GetSets<PyTable>()
-  .add_get<get_length>      ("length")
-  .add_get<get_width>       ("width")
+  .add_get<get_cell_cache_stats>    ("cell_cache_stats")
+  .add_get<get_length>              ("length")
+  .add_get<get_needs_python>        ("needs_python")
+  .add_get<get_object_cache_stats>  ("object_cache_stats")
+  .add_get<get_width>               ("width")
   ;
 
 
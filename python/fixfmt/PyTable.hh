@@ -11,6 +11,16 @@
 
 // FIXME: Columns should hold buffer refs, not the table.
 
+/*
+ * Counts lookups in the caches of formatted object column cells.
+ */
+struct ObjectCacheStats
+{
+  long hits = 0;
+  long misses = 0;
+};
+
+
 class PyTable
   : public py::ExtensionType
 {
@@ -23,6 +33,21 @@ public:
   // Holds references to the buffers referenced by the table's columns.
   std::vector<py::BufferRef> buffers_;
 
+  // Holds references to other objects that own memory referenced by the
+  // table's columns, such as Arrow array capsules.
+  std::vector<py::ref<py::Object>> objects_;
+
+  // True if any column calls into Python to format, so that rendering must
+  // hold the GIL.
+  bool needs_python_ = false;
+
+  // Number of renders in progress.  A render may release the GIL or call into
+  // Python, so other threads may run meanwhile; they may not change the table.
+  long num_renders_ = 0;
+
+  // Lookups in object columns' caches.
+  ObjectCacheStats object_cache_stats_;
+
 };
 
 
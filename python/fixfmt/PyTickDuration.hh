@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Python.h>
+
+#include "fixfmt.hh"
+#include "py.hh"
+
+//------------------------------------------------------------------------------
+
+class PyTickDuration
+  : public py::ExtensionType
+{
+public:
+
+  /**
+   * The wrapped formatter type.
+   */
+  using Formatter = fixfmt::TickDuration;
+
+  static py::Type type_;
+
+  PyTickDuration(std::unique_ptr<Formatter> fmt)
+    : fmt_(std::move(fmt))
+  {
+  }
+
+  std::unique_ptr<Formatter> const fmt_;
+
+};
+
@@ -1,4 +1,4 @@
-from   ._ext import Bool, Number, String, TickTime, TickDate
+from   ._ext import Bool, Number, String, TickTime, TickDate, TickDuration
 from   ._ext import center, elide, pad, palide, string_length
 
 __all__ = (
@@ -13,6 +13,7 @@ __all__ = (
     "string_length",
     "TickTime",
     "TickDate",
+    "TickDuration",
 )
 
 #-------------------------------------------------------------------------------
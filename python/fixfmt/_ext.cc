@@ -1,11 +1,16 @@
+#include <stdexcept>
+
 #include <Python.h>
 
 #include "PyBool.hh"
 #include "PyNumber.hh"
+#include "PyNumberStats.hh"
 #include "PyString.hh"
+#include "PyStringStats.hh"
 #include "PyTable.hh"
 #include "PyTickTime.hh"
 #include "PyTickDate.hh"
+#include "PyTickDuration.hh"
 #include "py.hh"
 
 using namespace py;
@@ -36,6 +41,9 @@ PyInit__ext(void)
   auto module = Module::Create(&testmod_module);
 
   try {
+    // Invalid arguments detected in the C++ library.
+    TranslateException<std::invalid_argument>::to(PyExc_ValueError);
+
     PyBool::type_.Ready();
     module->add(&PyBool::type_);
 
@@ -49,9 +57,15 @@ PyInit__ext(void)
     }
     module->add(&PyNumber::type_);
 
+    PyNumberStats::type_.Ready();
+    module->add(&PyNumberStats::type_);
+
     PyString::type_.Ready();
     module->add(&PyString::type_);
 
+    PyStringStats::type_.Ready();
+    module->add(&PyStringStats::type_);
+
     PyTable::type_.Ready();
     module->add(&PyTable::type_);
 
@@ -61,6 +75,9 @@ PyInit__ext(void)
     PyTickDate::type_.Ready();
     module->add(&PyTickDate::type_);
 
+    PyTickDuration::type_.Ready();
+    module->add(&PyTickDuration::type_);
+
     return module.release();
   }
   catch (Exception) {
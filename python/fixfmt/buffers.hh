@@ -0,0 +1,393 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <Python.h>
+
+#include "fixfmt/analyze.hh"
+#include "fixfmt/arrow.hh"
+#include "fixfmt/text.hh"
+#include "py.hh"
+
+//------------------------------------------------------------------------------
+
+namespace buffers {
+
+/*
+ * Returns the rows to analyze, from an (n, 2) int64 array of begin and end
+ * indices, or all `length` rows if `obj` is None.
+ */
+inline std::vector<fixfmt::Range>
+get_ranges(
+  PyObject* const obj,
+  long const length)
+{
+  if (obj == Py_None)
+    return {fixfmt::Range{0, length}};
+
+  py::BufferRef buffer(obj, PyBUF_C_CONTIGUOUS);
+  if (buffer->ndim != 2 || buffer->shape[1] != 2
+      || buffer->itemsize != sizeof(long))
+    throw py::TypeError("ranges not an (n, 2) int64 array");
+  auto const bounds = static_cast<long const*>(buffer->buf);
+  std::vector<fixfmt::Range> ranges;
+  ranges.reserve(buffer->shape[0]);
+  for (long i = 0; i < buffer->shape[0]; ++i) {
+    long const begin = bounds[2 * i];
+    long const end = bounds[2 * i + 1];
+    if (!(0 <= begin && begin <= end && end <= length))
+      throw py::ValueError("range out of bounds");
+    ranges.emplace_back(begin, end);
+  }
+  return ranges;
+}
+
+
+/*
+ * Returns the buffer's item type character, skipping a native byte order
+ * prefix, or 0 if it's not a single character.
+ */
+inline char
+get_type(
+  py::BufferRef& buffer)
+{
+  char const* type = buffer->format == nullptr ? "B" : buffer->format;
+  if (*type == '>' || *type == '!')
+    throw py::TypeError("non-native byte order");
+  if (*type == '@' || *type == '=' || *type == '<')
+    ++type;
+  return type[0] != 0 && type[1] == 0 ? type[0] : 0;
+}
+
+
+/*
+ * Calls `fn` with a null pointer to the buffer's number item type.  The buffer
+ * must have been requested with PyBUF_FORMAT.
+ */
+template<typename FN>
+inline auto
+with_number_type(
+  py::BufferRef& buffer,
+  FN&& fn)
+{
+  auto const size = buffer->itemsize;
+  switch (get_type(buffer)) {
+  case 'f': return fn((float*) nullptr);
+  case 'd': return fn((double*) nullptr);
+  case 'b': case 'h': case 'i': case 'l': case 'q':
+    switch (size) {
+    case 1: return fn((signed char*) nullptr);
+    case 2: return fn((short*) nullptr);
+    case 4: return fn((int*) nullptr);
+    case 8: return fn((long*) nullptr);
+    default: throw py::TypeError("wrong itemsize");
+    }
+  case 'B': case 'H': case 'I': case 'L': case 'Q':
+    switch (size) {
+    case 1: return fn((unsigned char*) nullptr);
+    case 2: return fn((unsigned short*) nullptr);
+    case 4: return fn((unsigned int*) nullptr);
+    case 8: return fn((unsigned long*) nullptr);
+    default: throw py::TypeError("wrong itemsize");
+    }
+  default:
+    throw py::TypeError("unsupported array type");
+  }
+}
+
+
+/*
+ * Returns the length in code points of an object's string, skipping escape
+ * sequences.
+ */
+inline size_t
+object_length(
+  py::Object* obj)
+{
+  py::ref<py::Object> str;
+  if (!py::Unicode::Check(obj)) {
+    str = obj->Str();
+    obj = str;
+  }
+  // Scan the string's own representation, without encoding it.
+  auto const data = PyUnicode_DATA(obj);
+  auto const len = PyUnicode_GET_LENGTH(obj);
+  switch (PyUnicode_KIND(obj)) {
+  case PyUnicode_1BYTE_KIND:
+    return fixfmt::code_point_length((Py_UCS1 const*) data,
+                                     (Py_UCS1 const*) data + len);
+  case PyUnicode_2BYTE_KIND:
+    return fixfmt::code_point_length((Py_UCS2 const*) data,
+                                     (Py_UCS2 const*) data + len);
+  default:
+    return fixfmt::code_point_length((Py_UCS4 const*) data,
+                                     (Py_UCS4 const*) data + len);
+  }
+}
+
+
+/*
+ * Returns the greatest length of the strings in `ranges` of a buffer of 'U'
+ * (UCS-4) or 'S' (UTF-8) `kind`, up to `max_size`.  Doesn't use the GIL, so
+ * may be called without it.
+ */
+inline size_t
+analyze_text(
+  py::BufferRef& buffer,
+  char const kind,
+  std::vector<fixfmt::Range> const& ranges,
+  size_t const max_size)
+{
+  auto const buf = (char const*) buffer->buf;
+  auto const itemsize = buffer->itemsize;
+  auto const stride = buffer->strides[0];
+  if (kind == 'U')
+    return fixfmt::analyze_strings(
+      (char32_t const*) buf, stride, ranges, itemsize / sizeof(char32_t),
+      max_size);
+  else
+    return fixfmt::analyze_strings(buf, stride, ranges, itemsize, max_size);
+}
+
+
+/*
+ * Returns the greatest length of the strings in `ranges` of a buffer of 'U'
+ * (UCS-4), 'S' (UTF-8) or 'O' (objects, as strings) `kind`, up to `max_size`.
+ * Releases the GIL, except for objects.
+ */
+inline size_t
+analyze_strings(
+  py::BufferRef& buffer,
+  char const kind,
+  std::vector<fixfmt::Range> const& ranges,
+  size_t const max_size)
+{
+  auto const buf = (char const*) buffer->buf;
+  auto const itemsize = buffer->itemsize;
+  auto const stride = buffer->strides[0];
+
+  if (kind == 'U') {
+    if (itemsize % sizeof(char32_t) != 0)
+      throw py::TypeError("wrong itemsize");
+    py::ReleaseGIL release;
+    return analyze_text(buffer, kind, ranges, max_size);
+  }
+  else if (kind == 'S') {
+    py::ReleaseGIL release;
+    return analyze_text(buffer, kind, ranges, max_size);
+  }
+  else if (kind == 'O') {
+    if (itemsize != sizeof(PyObject*))
+      throw py::TypeError("wrong itemsize");
+    size_t result = 0;
+    for (auto const& range : ranges)
+      for (long i = range.first; i < range.second && result < max_size; ++i)
+        result = std::max(
+          result, object_length(*(py::Object* const*) (buf + i * stride)));
+    return std::min(result, max_size);
+  }
+  else
+    throw py::ValueError("kind not U, S, or O");
+}
+
+
+/*
+ * Returns the string kind of a buffer, from its format: 'U', 'S', or 'O'.
+ */
+inline char
+get_string_kind(
+  py::BufferRef& buffer)
+{
+  char const* type = buffer->format == nullptr ? "B" : buffer->format;
+  if (*type == '@' || *type == '=' || *type == '<')
+    ++type;
+  if (strcmp(type, "O") == 0)
+    return 'O';
+  // A count, then 'w' for UCS-4 or 's' for bytes.
+  while ('0' <= *type && *type <= '9')
+    ++type;
+  if (strcmp(type, "w") == 0) {
+    if (buffer->itemsize % sizeof(char32_t) != 0)
+      throw py::TypeError("wrong itemsize");
+    return 'U';
+  }
+  else if (strcmp(type, "s") == 0)
+    return 'S';
+  else
+    throw py::TypeError("not a string array");
+}
+
+
+/*
+ * Returns the parts of `ranges` whose bits in the validity bitmap `valid` are
+ * set.  The bit for index `i` is bit `offset + i`, least significant first.
+ */
+inline std::vector<fixfmt::Range>
+get_valid_ranges(
+  uint8_t const* const valid,
+  long const offset,
+  std::vector<fixfmt::Range> const& ranges)
+{
+  std::vector<fixfmt::Range> result;
+  for (auto const& range : ranges)
+    for (long i = range.first; i < range.second; ) {
+      auto const is_valid = [&](long const j) {
+        auto const bit = offset + j;
+        return (valid[bit >> 3] >> (bit & 7)) & 1;
+      };
+      // Skip nulls, then take the run of valid entries.
+      while (i < range.second && !is_valid(i))
+        ++i;
+      long const begin = i;
+      while (i < range.second && is_valid(i))
+        ++i;
+      if (begin < i)
+        result.emplace_back(begin, i);
+    }
+  return result;
+}
+
+
+/*
+ * An array exported through the Arrow PyCapsule interface.  The capsules own
+ * the Arrow structs, and release them when they're destroyed.
+ */
+struct ArrowExport
+{
+  py::ref<py::Object> capsules;
+  ArrowSchema* schema = nullptr;
+  ArrowArray* array = nullptr;
+};
+
+
+/*
+ * Returns the pointer in a capsule named `name`.
+ */
+template<typename TYPE>
+inline TYPE*
+get_capsule(
+  py::Object* const capsule,
+  char const* const name)
+{
+  if (!PyCapsule_IsValid(capsule, name))
+    throw py::TypeError(std::string("not an ") + name + " capsule");
+  return static_cast<TYPE*>(PyCapsule_GetPointer(capsule, name));
+}
+
+
+/*
+ * Exports `obj`, which must implement the Arrow PyCapsule interface, i.e. an
+ * `__arrow_c_array__()` method.
+ */
+inline ArrowExport
+export_arrow(
+  py::Object* const obj)
+{
+  if (!PyObject_HasAttrString(obj, "__arrow_c_array__"))
+    throw py::TypeError("not an Arrow array");
+  auto capsules = obj->CallMethodObjArgs("__arrow_c_array__");
+  if (!py::Tuple::Check(capsules) 
+      || PyTuple_GET_SIZE((py::Object*) capsules) != 2)
+    throw py::TypeError("__arrow_c_array__ didn't return a pair");
+  auto const pair = py::cast<py::Tuple>(capsules);
+  auto const schema
+    = get_capsule<ArrowSchema>(pair->GetItem(0), "arrow_schema");
+  auto const array = get_capsule<ArrowArray>(pair->GetItem(1), "arrow_array");
+  return {std::move(capsules), schema, array};
+}
+
+
+/*
+ * The values of an exported Arrow array to analyze: the array's own values, or
+ * a dictionary array's dictionary values.
+ */
+struct ArrowValues
+{
+  ArrowSchema const* schema;
+  ArrowArray const* array;
+  // The rows to analyze, without nulls.
+  std::vector<fixfmt::Range> ranges;
+};
+
+
+/*
+ * Returns the values of `exported` to analyze.  `ranges_obj` is as for
+ * `get_ranges()`; it's ignored for a dictionary array, since dictionary values
+ * don't correspond to rows.
+ */
+inline ArrowValues
+get_arrow_values(
+  ArrowExport const& exported,
+  PyObject* const ranges_obj)
+{
+  ArrowValues values{exported.schema, exported.array, {}};
+  if (values.schema->release == nullptr || values.array->release == nullptr)
+    throw py::ValueError("released Arrow array");
+  if (values.schema->dictionary != nullptr) {
+    if (values.array->dictionary == nullptr)
+      throw py::ValueError("missing Arrow dictionary");
+    values.schema = values.schema->dictionary;
+    values.array = values.array->dictionary;
+    values.ranges = {fixfmt::Range{0, values.array->length}};
+  }
+  else
+    values.ranges = get_ranges(ranges_obj, values.array->length);
+
+  auto const& array = *values.array;
+  if (array.null_count != 0 && array.n_buffers > 0
+      && array.buffers[0] != nullptr)
+    values.ranges = get_valid_ranges(
+      static_cast<uint8_t const*>(array.buffers[0]), array.offset,
+      values.ranges);
+  return values;
+}
+
+
+/*
+ * Returns buffer `index` of an Arrow array, with the array's offset applied.
+ */
+template<typename TYPE>
+inline TYPE const*
+get_arrow_buffer(
+  ArrowArray const& array,
+  int const index)
+{
+  if (array.n_buffers <= index || array.buffers[index] == nullptr)
+    throw py::ValueError("missing Arrow buffer");
+  return static_cast<TYPE const*>(array.buffers[index]) + array.offset;
+}
+
+
+/*
+ * Calls `fn` with a null pointer to the number type of an Arrow `format`.
+ */
+template<typename FN>
+inline auto
+with_arrow_number_type(
+  char const* const format,
+  FN&& fn)
+{
+  if (format[0] != 0 && format[1] == 0)
+    switch (format[0]) {
+    case 'c': return fn((signed char*) nullptr);
+    case 'C': return fn((unsigned char*) nullptr);
+    case 's': return fn((short*) nullptr);
+    case 'S': return fn((unsigned short*) nullptr);
+    case 'i': return fn((int*) nullptr);
+    case 'I': return fn((unsigned int*) nullptr);
+    case 'l': return fn((long*) nullptr);
+    case 'L': return fn((unsigned long*) nullptr);
+    case 'f': return fn((float*) nullptr);
+    case 'g': return fn((double*) nullptr);
+    }
+  throw py::TypeError(std::string("not an Arrow number format: ") + format);
+}
+
+
+}  // namespace buffers
+
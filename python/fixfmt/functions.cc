@@ -1,17 +1,25 @@
 #include <cassert>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <functional>
 #include <iomanip>
 #include <limits>
+#include <memory>
 #include <string>
-
-#include "fixfmt/double-conversion/double-conversion.h"
-#include "fixfmt/double-conversion/fast-dtoa.h"
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "PyNumberStats.hh"
+#include "PyStringStats.hh"
+#include "buffers.hh"
+#include "fixfmt/analyze.hh"
 #include "fixfmt/text.hh"
 #include "py.hh"
 
 using namespace py;
 using std::string;
-using DTSC = fixfmt::double_conversion::DoubleToStringConverter;
 
 //------------------------------------------------------------------------------
 
@@ -19,104 +27,354 @@ using DTSC = fixfmt::double_conversion::DoubleToStringConverter;
 
 namespace {
 
-template<typename TYPE> constexpr auto MODE = DTSC::SHORTEST;
-template<> constexpr auto MODE<float> = DTSC::SHORTEST_SINGLE;
+/*
+ * Analyzes the `ranges` of a buffer of `VALUE`, divided by `scale` if positive,
+ * and returns the analysis as a tuple.
+ */
+template<typename VALUE>
+ref<Object> analyze_float_buffer(
+  BufferRef& buffer,
+  std::vector<fixfmt::Range> const& ranges,
+  int const max_precision,
+  int const num_threads,
+  double const scale)
+{
+  if (buffer->itemsize != sizeof(VALUE))
+    throw TypeError("wrong itemsize");
+
+  decltype(fixfmt::analyze_float((VALUE const*) nullptr, 0, 0, 0)) result;
+  {
+    ReleaseGIL release;
+    result = fixfmt::analyze_float(
+      (VALUE const*) buffer->buf, buffer->strides[0], ranges, max_precision,
+      num_threads, scale);
+  }
+
+  // FIXME-PY3: Use a StructSequenceType.
+  return (ref<Tuple>) (Tuple::builder
+    << Bool::from(result.has_nan)
+    << Bool::from(result.has_pos_inf)
+    << Bool::from(result.has_neg_inf)
+    << Long::FromLong(result.num)
+    << Float::FromDouble(result.min)
+    << Float::FromDouble(result.max)
+    << Long::FromLong(result.precision)
+  );
+}
+
 
 template<typename TYPE>
 ref<Object> analyze_float(Module* module, Tuple* args, Dict* kw_args)
 {
-  static char const* arg_names[] = {"buf", "max_precision", nullptr};
+  static char const* arg_names[]
+    = {"buf", "max_precision", "num_threads", "ranges", nullptr};
+  PyObject* array_obj;
+  int max_precision;
+  int num_threads = 0;
+  PyObject* ranges_obj = Py_None;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "Oi|iO", arg_names, &array_obj, &max_precision,
+    &num_threads, &ranges_obj);
+
+  BufferRef buffer(array_obj, PyBUF_STRIDES);
+  if (buffer->ndim != 1)
+    throw TypeError("not a one-dimensional array");
+  if (num_threads < 0)
+    throw ValueError("negative num_threads");
+
+  auto const ranges = buffers::get_ranges(ranges_obj, buffer->shape[0]);
+  return analyze_float_buffer<TYPE>(
+    buffer, ranges, max_precision, num_threads, 0);
+}
+
+
+/*
+ * Analyzes a one-dimensional array of floats or integers, divided by `scale`,
+ * as a number formatter with that scale shows them.  Scaled floats are
+ * analyzed in their own precision, and scaled integers as doubles.
+ */
+ref<Object> analyze_scaled(Module* module, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[]
+    = {"buf", "scale", "max_precision", "num_threads", "ranges", nullptr};
   PyObject* array_obj;
+  double scale;
   int max_precision;
+  int num_threads = 0;
+  PyObject* ranges_obj = Py_None;
   Arg::ParseTupleAndKeywords(
-    args, kw_args, "Oi", arg_names, &array_obj, &max_precision);
+    args, kw_args, "Odi|iO", arg_names, &array_obj, &scale, &max_precision,
+    &num_threads, &ranges_obj);
 
-  BufferRef buffer(array_obj, PyBUF_ND);
+  BufferRef buffer(array_obj, PyBUF_STRIDES | PyBUF_FORMAT);
+  if (buffer->ndim != 1)
+    throw TypeError("not a one-dimensional array");
+  if (!(scale > 0))
+    throw ValueError("scale not positive");
+  if (num_threads < 0)
+    throw ValueError("negative num_threads");
+  auto const ranges = buffers::get_ranges(ranges_obj, buffer->shape[0]);
+
+  return buffers::with_number_type(buffer, [&](auto const* const dummy) {
+    using TYPE = typename std::decay<decltype(*dummy)>::type;
+    return analyze_float_buffer<TYPE>(
+      buffer, ranges, max_precision, num_threads, scale);
+  });
+}
+
+
+template<typename TYPE>
+ref<Object> analyze_int(Module* module, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[] = {"buf", "ranges", nullptr};
+  PyObject* array_obj;
+  PyObject* ranges_obj = Py_None;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "O|O", arg_names, &array_obj, &ranges_obj);
+
+  BufferRef buffer(array_obj, PyBUF_STRIDES);
   if (buffer->ndim != 1)
     throw TypeError("not a one-dimensional array");
   if (buffer->itemsize != sizeof(TYPE))
     throw TypeError("wrong itemsize");
-  TYPE const* const array = (TYPE const* const) buffer->buf;
-  size_t const length = buffer->shape[0];
-
-  bool has_nan = false;
-  bool has_pos_inf = false;
-  bool has_neg_inf = false;
-  size_t num = 0;
-  TYPE min = std::numeric_limits<TYPE>::max();
-  TYPE max = std::numeric_limits<TYPE>::min();
-
-  // Estimate precision truncating 'precision' digits to the right of the
-  // decimal point, and comparing the result to 'tolerance'.  
-  // FIXME: Might not be correct for long double.
-  int precision = 0;
-  TYPE precision_scale = 1;
-
-  // Note: Weird.  LLVM 6.1.0 on OSX vectorizes this loop only if the precision
-  // logic is _present_, with the result that it runs _faster_ than without.
-
-  for (size_t i = 0; i < length; ++i) {
-    TYPE const val = array[i];
-    // Flag NaN.
-    if (std::isnan(val)) {
-      has_nan = true;
-      continue;
+  auto const ranges = buffers::get_ranges(ranges_obj, buffer->shape[0]);
+
+  fixfmt::IntAnalysis<TYPE> result;
+  {
+    ReleaseGIL release;
+    result = fixfmt::analyze_int(
+      (TYPE const*) buffer->buf, buffer->strides[0], ranges);
+  }
+
+  // Unary plus promotes chars, which would otherwise not be numbers.
+  return (ref<Tuple>) (Tuple::builder
+    << Long::FromLong(result.num)
+    << Long::from(+result.min)
+    << Long::from(+result.max)
+    << Long::FromLong(result.digits)
+  );
+}
+
+
+/*
+ * Returns the greatest length of the strings in a one-dimensional array of
+ * 'U' (UCS-4), 'S' (UTF-8) or 'O' (objects, as strings) `kind`, up to
+ * `max_size`.  Stops scanning once a string reaches `max_size`.  If `ranges`
+ * is given, scans only those rows.
+ */
+ref<Object> analyze_strings(Module* module, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[]
+    = {"buf", "kind", "itemsize", "max_size", "ranges", nullptr};
+  PyObject* array_obj;
+  char* kind;
+  Py_ssize_t itemsize;
+  Py_ssize_t max_size;
+  PyObject* ranges_obj = Py_None;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "Osnn|O", arg_names, &array_obj, &kind, &itemsize,
+    &max_size, &ranges_obj);
+
+  BufferRef buffer(array_obj, PyBUF_STRIDES);
+  if (buffer->ndim != 1)
+    throw TypeError("not a one-dimensional array");
+  if (buffer->itemsize != itemsize)
+    throw TypeError("wrong itemsize");
+  if (max_size < 0)
+    throw ValueError("negative max_size");
+  auto const ranges = buffers::get_ranges(ranges_obj, buffer->shape[0]);
+  if (strlen(kind) != 1)
+    throw ValueError("kind not U, S, or O");
+  auto const result
+    = buffers::analyze_strings(buffer, kind[0], ranges, max_size);
+  return Long::FromLong(result);
+}
+
+
+/*
+ * Describes an Arrow array: returns the Arrow format of its values, or of its
+ * dictionary's values, whether it's a dictionary array, and its length.
+ */
+ref<Object> arrow_info(Module* module, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[] = {"array", nullptr};
+  Object* array;
+  Arg::ParseTupleAndKeywords(args, kw_args, "O", arg_names, &array);
+
+  auto const exported = buffers::export_arrow(array);
+  auto const values = buffers::get_arrow_values(exported, Py_None);
+  return (ref<Tuple>) (Tuple::builder
+    << Unicode::from(values.schema->format)
+    << Bool::from(values.schema != exported.schema)
+    << Long::FromLong(exported.array->length));
+}
+
+
+/*
+ * Analyzes many one-dimensional arrays at once, each into its own stats.
+ * `columns` is a list of (stats, buf, ranges) tuples, where `stats` is a
+ * NumberStats or StringStats, and `ranges` is as for the other analysis
+ * functions, or none for all rows.
+ *
+ * `buf` may also be an Arrow array, whose buffers are analyzed in place,
+ * skipping nulls.  For a dictionary array, the dictionary values are analyzed,
+ * and `ranges` is ignored.
+ *
+ * Number, 'U', and 'S' arrays are analyzed concurrently on up to `num_threads`
+ * threads, or one per CPU if zero, with the GIL released.  Object arrays need
+ * the GIL, so are analyzed first.  The stats are updated once all are done.
+ */
+ref<Object> analyze_columns(Module* module, Tuple* args, Dict* kw_args)
+{
+  static char const* arg_names[] = {"columns", "num_threads", nullptr};
+  PyObject* columns_obj;
+  int num_threads = 0;
+  Arg::ParseTupleAndKeywords(
+    args, kw_args, "O|i", arg_names, &columns_obj, &num_threads);
+  if (!List::Check(columns_obj))
+    throw TypeError("columns not a list");
+  if (num_threads < 0)
+    throw ValueError("negative num_threads");
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  struct Column
+  {
+    // The array, as a buffer or as an exported Arrow array.
+    std::unique_ptr<BufferRef> buffer;
+    buffers::ArrowExport arrow;
+    ArrowArray const* arrow_values = nullptr;
+    std::vector<fixfmt::Range> ranges;
+    // Owns the stats object, which is used without the GIL.
+    ref<Object> stats;
+    PyNumberStats* number_stats = nullptr;
+    PyStringStats* string_stats = nullptr;
+    // Results, to merge into the stats.
+    fixfmt::NumberStats number;
+    long num_strings = 0;
+    size_t size = 0;
+  };
+
+  // Check all the columns, and collect the analyses to run without the GIL.
+  // Each takes the number of threads it may use.
+  std::vector<std::unique_ptr<Column>> columns;
+  std::vector<std::function<void(int)>> tasks;
+  // Exporting an Arrow array runs Python code, which may change the list, so
+  // check its size each time, and hold on to each item while using it.
+  for (Py_ssize_t i = 0; i < PyList_GET_SIZE(columns_obj); ++i) {
+    auto const item = ref<Object>::of(PyList_GET_ITEM(columns_obj, i));
+    if (!Tuple::Check(item))
+      throw TypeError("column not a tuple");
+    PyObject* stats_obj;
+    PyObject* array_obj;
+    PyObject* ranges_obj;
+    Arg::ParseTuple(
+      cast<Tuple>(item), "OOO", &stats_obj, &array_obj, &ranges_obj);
+
+    columns.emplace_back(new Column);
+    auto& column = *columns.back();
+    column.stats = ref<Object>::of(stats_obj);
+    char const* arrow_format = nullptr;
+    if (PyObject_CheckBuffer(array_obj)) {
+      column.buffer = std::make_unique<BufferRef>(
+        array_obj, PyBUF_STRIDES | PyBUF_FORMAT);
+      if ((*column.buffer)->ndim != 1)
+        throw TypeError("not a one-dimensional array");
+      column.ranges 
+        = buffers::get_ranges(ranges_obj, (*column.buffer)->shape[0]);
+    }
+    else {
+      column.arrow = buffers::export_arrow((Object*) array_obj);
+      auto values = buffers::get_arrow_values(column.arrow, ranges_obj);
+      column.arrow_values = values.array;
+      column.ranges = std::move(values.ranges);
+      arrow_format = values.schema->format;
     }
-    // Flag positive and negative infinity.
-    if (std::isinf(val)) {
-      if (val > 0)
-        has_pos_inf = true;
+
+    if (PyObject_TypeCheck(stats_obj, &PyNumberStats::type_)) {
+      auto const stats = column.number_stats = (PyNumberStats*) stats_obj;
+      auto const add = [&](auto const* const values, long const stride) {
+        using TYPE = typename std::decay<decltype(*values)>::type;
+        tasks.emplace_back([&column, stats, values, stride](int num_threads) {
+          fixfmt::analyze_number(
+            column.number, values, stride, column.ranges,
+            stats->get_max_precision<TYPE>(), num_threads, stats->scale_);
+        });
+      };
+      if (column.buffer)
+        buffers::with_number_type(*column.buffer, [&](auto const* dummy) {
+          using TYPE = typename std::decay<decltype(*dummy)>::type;
+          auto& buffer = *column.buffer;
+          add((TYPE const*) buffer->buf, buffer->strides[0]);
+        });
       else
-        has_neg_inf = true;
-      continue;
+        buffers::with_arrow_number_type(arrow_format, [&](auto const* dummy) {
+          using TYPE = typename std::decay<decltype(*dummy)>::type;
+          add(
+            buffers::get_arrow_buffer<TYPE>(*column.arrow_values, 1),
+            sizeof(TYPE));
+        });
     }
-    // Keep count of non-NaN/infinity values.
-    ++num;
-    // Compute min and max, excluding NaN and infinity.
-    if (val < min)
-      min = val;
-    if (val > max)
-      max = val;
-
-    if (precision == max_precision)
-      // At max precision; no need to check further.
-      ;
-    else {
-      // We need to check if this value requires additional precision to format
-      // accurately.  Start with a naive check.
-      double const scaled = val * precision_scale;
-      if (long(std::round(scaled)) == scaled)
-        // Good to go.
-        ;
+    else if (PyObject_TypeCheck(stats_obj, &PyStringStats::type_)) {
+      auto const stats = column.string_stats = (PyStringStats*) stats_obj;
+      auto const max_size = stats->max_size_;
+      for (auto const& range : column.ranges)
+        column.num_strings += range.second - range.first;
+      if (stats->stats_.size >= max_size)
+        column.size = max_size;
+      else if (!column.buffer) {
+        // UTF-8 strings with 32- or 64-bit offsets.
+        auto const add = [&](auto const* const offsets) {
+          auto const data 
+            = buffers::get_arrow_buffer<char>(*column.arrow_values, 2)
+              - column.arrow_values->offset;
+          tasks.emplace_back([&column, offsets, data, max_size](int) {
+            column.size = fixfmt::analyze_strings(
+              offsets, data, column.ranges, max_size);
+          });
+        };
+        if (strcmp(arrow_format, "u") == 0)
+          add(buffers::get_arrow_buffer<int32_t>(*column.arrow_values, 1));
+        else if (strcmp(arrow_format, "U") == 0)
+          add(buffers::get_arrow_buffer<int64_t>(*column.arrow_values, 1));
+        else
+          throw TypeError(
+            std::string("not an Arrow string format: ") + arrow_format);
+      }
       else {
-        // Might need more precision.  We need to do full-blown formatting.
-        char buf[384];  // Enough room for DBL_MAX.
-        bool sign;
-        int length;
-        int decimal_pos;
-        DTSC::DoubleToAscii(
-          std::abs(val), MODE<TYPE>, 0,
-          buf, sizeof(buf), &sign, &length, &decimal_pos);
-
-        auto const prec = std::min(length - decimal_pos, max_precision);
-        if (prec > precision) {
-          precision = prec;
-          precision_scale = fixfmt::pow10(precision);
-        }
+        auto& buffer = *column.buffer;
+        auto const kind = buffers::get_string_kind(buffer);
+        if (kind == 'O')
+          column.size = buffers::analyze_strings(
+            buffer, kind, column.ranges, max_size);
+        else
+          tasks.emplace_back([&buffer, &column, kind, max_size](int) {
+            column.size = buffers::analyze_text(
+              buffer, kind, column.ranges, max_size);
+          });
       }
     }
+    else
+      throw TypeError("not NumberStats or StringStats");
   }
 
-  // FIXME-PY3: Use a StructSequenceType.
-  return (ref<Tuple>) (Tuple::builder
-    << Bool::from(has_nan)
-    << Bool::from(has_pos_inf)
-    << Bool::from(has_neg_inf)
-    << Long::FromLong(num)
-    << Float::FromDouble(min)
-    << Float::FromDouble(max)
-    << Long::FromLong(precision)
-  );
+  {
+    ReleaseGIL release;
+    // Columns are the units of work; split threads among them if they're few.
+    long const num_tasks = tasks.size();
+    int const column_threads
+      = std::max(1l, num_threads / std::max(1l, num_tasks));
+    fixfmt::run_parallel(num_tasks, num_threads, [&](long const t) {
+      tasks[t](column_threads);
+    });
+  }
+
+  for (auto const& column : columns)
+    if (column->number_stats != nullptr)
+      column->number_stats->stats_.merge(column->number);
+    else
+      column->string_stats->stats_.update(column->num_strings, column->size);
+  return none_ref();
 }
 
 
@@ -253,13 +511,25 @@ ref<Object> string_length(Module* module, Tuple* args, Dict* kw_args)
 Methods<Module>& add_functions(Methods<Module>& methods)
 {
   methods
-    .add<analyze_float<double>> ("analyze_double")
-    .add<analyze_float<float>>  ("analyze_float")
-    .add<center>                ("center")
-    .add<elide>                 ("elide")
-    .add<pad>                   ("pad")
-    .add<palide>                ("palide")
-    .add<string_length>         ("string_length")
+    .add<analyze_columns>             ("analyze_columns")
+    .add<arrow_info>                  ("arrow_info")
+    .add<analyze_float<double>>       ("analyze_double")
+    .add<analyze_float<float>>        ("analyze_float")
+    .add<analyze_scaled>              ("analyze_scaled")
+    .add<analyze_strings>             ("analyze_strings")
+    .add<analyze_int<signed char>>    ("analyze_int8")
+    .add<analyze_int<short>>          ("analyze_int16")
+    .add<analyze_int<int>>            ("analyze_int32")
+    .add<analyze_int<long>>           ("analyze_int64")
+    .add<analyze_int<unsigned char>>  ("analyze_uint8")
+    .add<analyze_int<unsigned short>> ("analyze_uint16")
+    .add<analyze_int<unsigned int>>   ("analyze_uint32")
+    .add<analyze_int<unsigned long>>  ("analyze_uint64")
+    .add<center>                      ("center")
+    .add<elide>                       ("elide")
+    .add<pad>                         ("pad")
+    .add<palide>                      ("palide")
+    .add<string_length>               ("string_length")
     ;
   return methods;
 }
@@ -4,12 +4,14 @@ Formatting for numpy arrays.
 
 #-------------------------------------------------------------------------------
 
-from   math import floor, log10
+from   math import ceil, floor, log, log1p, log10
 import numpy as np
 import re
 
-from   ._ext import Bool, Number, String, TickTime, TickDate
-from   ._ext import string_length, analyze_double, analyze_float
+from   ._ext import Bool, Number, String, TickTime, TickDate, TickDuration
+from   ._ext import NumberStats, StringStats
+from   ._ext import string_length
+from   . import _ext
 
 #-------------------------------------------------------------------------------
 
@@ -50,8 +52,47 @@ DEFAULT_CFG = {
         "max_precision" : None,
         "min_precision" : None,
     },
+    "duration": {
+        "min_width"     : 0,
+        "max_precision" : None,
+        "min_precision" : None,
+        "day_size"      : None,
+        "sign"          : None,
+    },
 }
 
+# Number of ticks per second, as a power of ten, for datetime64 and timedelta64
+# units.
+TICK_SCALES = {
+    "s"     : 0,
+    "ms"    : 3,
+    "us"    : 6,
+    "ns"    : 9,
+}
+
+# The int64 representation of numpy's NaT.
+NAT_VALUE = np.iinfo("int64").min
+
+# Numpy dtypes for Arrow formats of primitive and string values.
+ARROW_DTYPES = {
+    "b"     : "bool",
+    "c"     : "int8",
+    "C"     : "uint8",
+    "s"     : "int16",
+    "S"     : "uint16",
+    "i"     : "int32",
+    "I"     : "uint32",
+    "l"     : "int64",
+    "L"     : "uint64",
+    "f"     : "float32",
+    "g"     : "float64",
+    "u"     : "str",
+    "U"     : "str",
+}
+
+# Arrow formats of timestamps, with an optional time zone, and durations.
+ARROW_TIME_FORMAT = re.compile(r"t([sD])([smun])(?::.*)?$")
+
 def num_digits(value):
     """
     Returns the number of decimal digits required to represent a value.
@@ -62,6 +103,97 @@ def num_digits(value):
     )
 
 
+def sample_ranges(length, head, tail, error=None, seed=0):
+    """
+    Returns row ranges from which to choose a formatter for the first `head` and
+    last `tail` of `length` rows, as an (n, 2) int64 array of begin and end
+    indices.
+
+    :param error:
+      If not none, also samples the rows in between, one from each of equal
+      strata, enough that with 99% confidence at most this fraction of them
+      need a wider formatter than the sample.
+    """
+    head = min(max(head, 0), length)
+    tail = min(max(tail, 0), length - head)
+    ranges = [(0, head)]
+    begin, end = head, length - tail
+    if error is not None and error < 1 and begin < end:
+        num = end - begin if error <= 0 else ceil(log(0.01) / log1p(-error))
+        if num >= end - begin:
+            ranges.append((begin, end))
+        else:
+            bounds = np.linspace(begin, end, num + 1).astype("int64")
+            rows = np.random.default_rng(seed).integers(bounds[:-1], bounds[1:])
+            ranges.extend((r, r + 1) for r in rows)
+    ranges.append((end, length))
+    return np.array(ranges, dtype="int64")
+
+
+def is_arrow(arr):
+    """
+    True if `arr` is an Arrow array, exported with the Arrow PyCapsule
+    interface.
+    """
+    return (
+        not isinstance(arr, np.ndarray)
+        and hasattr(arr, "__arrow_c_array__"))
+
+
+def get_dtype(arr):
+    """
+    Returns the dtype of `arr`, or for an Arrow array, the numpy dtype
+    corresponding to its values, or its dictionary's values.
+    """
+    if not is_arrow(arr):
+        return arr.dtype
+
+    fmt, _, _ = _ext.arrow_info(arr)
+    try:
+        return np.dtype(ARROW_DTYPES[fmt])
+    except KeyError:
+        pass
+    match = ARROW_TIME_FORMAT.match(fmt)
+    if match is None:
+        raise TypeError("unsupported Arrow format: {}".format(fmt))
+    kind, unit = match.groups()
+    return np.dtype("{}[{}]".format(
+        "datetime64" if kind == "s" else "timedelta64",
+        "s" if unit == "s" else unit + "s"))
+
+
+def arrow_values(arr, ranges=None):
+    """
+    Returns an ndarray of the values of Arrow array `arr`, and `ranges`.  For a
+    dictionary array, returns its dictionary values, and no ranges.
+    """
+    _, dictionary, _ = _ext.arrow_info(arr)
+    if dictionary:
+        return np.asarray(arr.dictionary), None
+    return np.asarray(arr), ranges
+
+
+def take_ranges(arr, ranges):
+    """
+    Returns the rows of `arr` in `ranges`, or all rows if `ranges` is none.
+    """
+    return (
+        arr if ranges is None
+        else np.concatenate([arr[:0]] + [arr[b : e] for b, e in ranges]))
+
+
+def native_rows(arr, ranges=None):
+    """
+    Returns `arr` and `ranges` for analysis, which requires native byte order.
+    If `arr` isn't native, returns its rows in `ranges` converted, and no
+    ranges.
+    """
+    if arr.dtype.isnative:
+        return arr, ranges
+    arr = take_ranges(arr, ranges)
+    return arr.astype(arr.dtype.newbyteorder("=")), None
+
+
 def choose_formatter_bool(arr, min_width=0, cfg=DEFAULT_CFG["bool"]):
     min_width   = max(min_width, cfg["min_width"])
     true        = cfg["true"]
@@ -74,33 +206,50 @@ def choose_formatter_bool(arr, min_width=0, cfg=DEFAULT_CFG["bool"]):
     return Bool(true, false, size=size)
 
 
-def choose_formatter_number(arr, min_width=0, cfg=DEFAULT_CFG["number"]):
+def make_stats(dtype, cfg=DEFAULT_CFG):
+    """
+    Returns empty stats for analyzing arrays of `dtype`.
+
+    Update the stats with each array or chunk, or merge stats analyzed
+    separately, such as in parallel, and pass them to `choose_formatter()`.
+    All chunks must be analyzed with the same `cfg`.
+    """
+    dtype = np.dtype(dtype)
+    if dtype.kind in "fiu":
+        scale = cfg["number"]["scale"]
+        return NumberStats(
+            max_precision=cfg["number"]["max_precision"],
+            scale=None if scale is None else scale[0])
+    elif dtype.kind in "OSU":
+        return StringStats(cfg["string"]["max_size"])
+    else:
+        raise TypeError("no stats for {}".format(dtype))
+
+
+def choose_formatter_number(
+        arr, min_width=0, cfg=DEFAULT_CFG["number"], ranges=None, stats=None):
     min_width   = max(min_width, cfg["min_width"])
 
-    # Analyze the array to determine relevant properties.
+    # Analyze the array to determine relevant properties.  Scaled values are
+    # analyzed as divided by the scale, without modifying the array.
     scale = cfg["scale"]
-    if scale is not None:
-        scale_factor, _ = scale
-        arr /= scale_factor
-
-    if arr.dtype.kind == "f":
-        # analyze_*() require arguments to support the buffer C API;
-        # noncontiguous arrays do not seem to.  FIXME: Not sure why not.
-        arr = np.ascontiguousarray(arr)
-        max_precision = cfg["max_precision"]
-        if max_precision is None:
-            max_precision = 16 if arr.dtype.itemsize == 8 else 8
-        analyze = analyze_double if arr.dtype.itemsize == 8 else analyze_float
-        (has_nan, has_pos_inf, has_neg_inf, num_vals, min_val, max_val, 
-            val_prec) = analyze(arr, max_precision)
-    elif arr.dtype.kind in "iu":
-        has_nan = has_pos_inf = has_neg_inf = False
-        num_vals = len(arr)
-        min_val = arr.min()
-        max_val = arr.max()
-        val_prec = 0
-    else:
-        raise TypeError("not a number dtype: {}".format(arr.dtype))
+    if stats is None:
+        if arr.dtype.kind not in "fiu":
+            raise TypeError("not a number dtype: {}".format(arr.dtype))
+        stats = make_stats(arr.dtype, {"number": cfg})
+        arr, ranges = native_rows(arr, ranges)
+        stats.update(arr, ranges=ranges)
+    elif (stats.max_precision != cfg["max_precision"]
+          or stats.scale != (None if scale is None else scale[0])):
+        raise ValueError("stats not analyzed with cfg")
+
+    has_nan     = stats.has_nan
+    has_pos_inf = stats.has_pos_inf
+    has_neg_inf = stats.has_neg_inf
+    num_vals    = stats.num
+    min_val     = stats.min
+    max_val     = stats.max
+    val_prec    = stats.precision
 
     inf = cfg["inf"]
     nan = cfg["nan"]
@@ -117,7 +266,12 @@ def choose_formatter_number(arr, min_width=0, cfg=DEFAULT_CFG["number"]):
 
     size = cfg["size"]
     if size is None:
-        size = 1 if num_vals == 0 else num_digits(max(abs(min_val), abs(max_val)))
+        if stats.integer:
+            size = stats.digits
+        else:
+            size = (
+                1 if num_vals == 0
+                else num_digits(max(abs(min_val), abs(max_val))))
 
     precision = cfg["precision"]
     if precision is None:
@@ -148,7 +302,8 @@ def choose_formatter_number(arr, min_width=0, cfg=DEFAULT_CFG["number"]):
     return fmt
 
 
-def choose_formatter_datetime64(values, min_width=0, cfg=DEFAULT_CFG["time"]):
+def choose_formatter_datetime64(
+        values, min_width=0, cfg=DEFAULT_CFG["time"], ranges=None):
     min_width   = max(min_width, cfg["min_width"])
 
     # FIXME: Is this really the right way to extract the datetime64 tick scale??
@@ -158,17 +313,13 @@ def choose_formatter_datetime64(values, min_width=0, cfg=DEFAULT_CFG["time"]):
     if scale == "D":
         return TickDate()
     try:
-        scale = {
-            "s"     : 0,
-            "ms"    : 3,
-            "us"    : 6,
-            "ns"    : 9,
-        }[scale]
+        scale = TICK_SCALES[scale]
     except KeyError:
         raise TypeError(f"no default formatter for datetime64 scale {scale}")
 
     # FIXME: Accelerate this with an extension module.
-    values = values.astype("int64")
+    # Reinterpret the ticks in place.
+    values = take_ranges(values, ranges).view("int64")
     max_prec = cfg["max_precision"]
     max_prec = min(scale, 9 if max_prec is None else max_prec)
     min_prec = cfg["min_precision"]
@@ -183,41 +334,179 @@ def choose_formatter_datetime64(values, min_width=0, cfg=DEFAULT_CFG["time"]):
     return TickTime(10 ** scale, precision)
 
 
-def choose_formatter_str(arr, min_width=0, cfg=DEFAULT_CFG["string"]):
+def choose_formatter_timedelta64(
+        values, min_width=0, cfg=DEFAULT_CFG["duration"], ranges=None):
+    min_width   = max(min_width, cfg["min_width"])
+
+    match = re.match(r"timedelta64\[(.*)\]$", values.dtype.name)
+    assert match is not None
+    scale = match.group(1)
+    try:
+        scale = TICK_SCALES[scale]
+    except KeyError:
+        raise TypeError(f"no default formatter for timedelta64 scale {scale}")
+
+    # Reinterpret the ticks in place, and ignore NaT.
+    values = take_ranges(values, ranges).view("int64")
+    values = values[values != NAT_VALUE]
+
+    max_prec = cfg["max_precision"]
+    max_prec = min(scale, 9 if max_prec is None else max_prec)
+    min_prec = cfg["min_precision"]
+    min_prec = 0 if min_prec is None else min_prec
+    for precision in range(max_prec, min_prec, -1):
+        if not (values % (10 ** (scale - precision + 1)) == 0).all():
+            break
+    else:
+        precision = min_prec
+    precision = -1 if precision < 1 else precision
+
+    sign = cfg["sign"]
+    if sign is None:
+        sign = "-" if len(values) > 0 and values.min() < 0 else " "
+
+    day_size = cfg["day_size"]
+    if day_size is None:
+        max_ticks = (
+            0 if len(values) == 0 
+            else max(abs(int(values.min())), abs(int(values.max())))
+        )
+        # Round as the formatter will, since this may carry into the hours or
+        # days.  Rounding half up may overestimate, but never underestimates.
+        unit = 10 ** max(scale - max(precision, 0), 0)
+        max_secs = (max_ticks + unit // 2) // unit * unit // 10 ** scale
+        # Show days only if the hours field would overflow.
+        day_size = 0 if max_secs < 100 * 3600 else num_digits(max_secs // 86400)
+
+    fmt = TickDuration(10 ** scale, precision, day_size=day_size, sign=sign)
+    extra = min_width - fmt.width
+    if extra > 0:
+        # Expand days to achieve minimum width.  Showing them costs three
+        # columns, for the "0d " prefix, so this may overshoot by up to two.
+        day_size = day_size + extra if day_size > 0 else max(extra - 2, 1)
+        fmt = TickDuration(
+            10 ** scale, precision, day_size=day_size, sign=sign)
+    return fmt
+
+
+def choose_formatter_str(
+        arr, min_width=0, cfg=DEFAULT_CFG["string"], ranges=None, stats=None):
     min_width = max(min_width, cfg["min_width"])
 
     size = cfg["size"]
     if size is None:
         min_size = cfg["min_size"]
         max_size = cfg["max_size"]
-        if arr.dtype.kind == "O":
-            size = lambda x: string_length(str(x))
-        elif arr.dtype.kind == "S":
-            # FIXME: For now we assume default-encoded strings.
-            size = lambda x: string_length(x.decode())
-        elif arr.dtype.kind == "U":
-            size = string_length
-        size = np.vectorize(size)(arr).max()
-        size = max(min_width, min_size, min(size, max_size))
+        if stats is None:
+            # FIXME: For now we assume 'S' strings are UTF-8.
+            arr, ranges = native_rows(arr, ranges)
+            size = _ext.analyze_strings(
+                arr, arr.dtype.kind, arr.dtype.itemsize, max_size,
+                ranges=ranges)
+        elif stats.max_size != max_size:
+            raise ValueError("stats not analyzed with cfg")
+        else:
+            size = stats.size
+        size = max(min_width, min_size, size)
 
     return String(
         size, ellipsis=cfg["ellipsis"], pad=cfg["pad"],
         elide_pos=cfg["elide_pos"], pad_pos=cfg["pad_pos"])
 
 
-def choose_formatter(arr, min_width=0, cfg=DEFAULT_CFG):
+def choose_formatter(
+        arr, min_width=0, cfg=DEFAULT_CFG, ranges=None, stats=None):
+    """
+    Chooses a formatter for the values of `arr`.
+
+    :param ranges:
+      If not none, an (n, 2) int64 array of begin and end indices of the only
+      rows to consider, such as from `sample_ranges()`.
+    :param stats:
+      If not none, stats from `make_stats()` already updated with the values,
+      in which case `arr` is not analyzed and may be none.
+    """
     min_width = max(min_width, cfg["min_width"])
 
+    if stats is None and is_arrow(arr):
+        fmt, = choose_formatters([arr], [min_width], [cfg], [ranges])
+        return fmt
+
+    if isinstance(stats, NumberStats):
+        return choose_formatter_number(
+            arr, min_width, cfg=cfg["number"], stats=stats)
+    elif isinstance(stats, StringStats):
+        return choose_formatter_str(
+            arr, min_width, cfg=cfg["string"], stats=stats)
+    elif stats is not None:
+        raise TypeError("not stats: {!r}".format(stats))
+
     dtype = arr.dtype
     if dtype.kind == "b":
         return choose_formatter_bool(arr, min_width, cfg=cfg["bool"])
     elif dtype.kind in "fiu":
-        return choose_formatter_number(arr, min_width, cfg=cfg["number"])
+        return choose_formatter_number(
+            arr, min_width, cfg=cfg["number"], ranges=ranges)
     elif dtype.kind == "M":
-        return choose_formatter_datetime64(arr, min_width, cfg=cfg["time"])
+        return choose_formatter_datetime64(
+            arr, min_width, cfg=cfg["time"], ranges=ranges)
+    elif dtype.kind == "m":
+        return choose_formatter_timedelta64(
+            arr, min_width, cfg=cfg["duration"], ranges=ranges)
     elif dtype.kind in "OSU":
-        return choose_formatter_str(arr, min_width, cfg=cfg["string"])
+        return choose_formatter_str(
+            arr, min_width, cfg=cfg["string"], ranges=ranges)
     else:
         raise TypeError("no default formatter for {}".format(dtype))
 
 
+def choose_formatters(
+        arrs, min_widths=None, cfgs=None, ranges=None, num_threads=0):
+    """
+    Chooses formatters for the values of many arrays at once.
+
+    The number and string arrays are analyzed together, on up to
+    `num_threads` threads, or one per CPU if zero.  Number and string Arrow
+    arrays are analyzed in place, without their nulls.
+
+    :param min_widths:
+      A min width for each array, or none for zero.
+    :param cfgs:
+      A cfg for each array, or none for the default.
+    :param ranges:
+      Ranges for each array, as for `choose_formatter()`, or none for all rows.
+    :return:
+      A formatter for each array.
+    """
+    num = len(arrs)
+    min_widths  = [0] * num if min_widths is None else min_widths
+    cfgs        = [DEFAULT_CFG] * num if cfgs is None else cfgs
+    ranges      = [None] * num if ranges is None else ranges
+
+    # Analyze the arrays for which stats suffice all in one call.
+    arrs = list(arrs)
+    ranges = list(ranges)
+    stats = []
+    columns = []
+    for i, (arr, cfg) in enumerate(zip(arrs, cfgs)):
+        dtype = get_dtype(arr)
+        kind = dtype.kind
+        if kind in "fiu" or (kind in "OSU" and cfg["string"]["size"] is None):
+            arr_stats = make_stats(dtype, cfg)
+            columns.append(
+                (arr_stats, arr, ranges[i]) if is_arrow(arr)
+                else (arr_stats, *native_rows(arr, ranges[i])))
+        else:
+            arr_stats = None
+            if is_arrow(arr):
+                arrs[i], ranges[i] = arrow_values(arr, ranges[i])
+        stats.append(arr_stats)
+    _ext.analyze_columns(columns, num_threads=num_threads)
+
+    return [
+        choose_formatter(arr, min_width, cfg, ranges=arr_ranges, stats=s)
+        for arr, min_width, cfg, arr_ranges, s
+        in zip(arrs, min_widths, cfgs, ranges, stats)
+    ]
+
+
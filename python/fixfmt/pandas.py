@@ -1,3 +1,4 @@
+import numpy as np
 import pandas as pd
 
 from   . import table
@@ -9,27 +10,59 @@ def from_dataframe(df, cfg, names=container.ALL):
     tbl = table.Table(cfg)
 
     def get_values(series):
+        """
+        Returns values, codes for a categorical or none, and a missing mask
+        for a nullable type or none.
+        """
+        values = series.array
         if series.dtype.name == "category":
-            # Construct an explicit array of values.
-            # FIXME: Wasteful.  We should instead read through the categories.
-            return series.cat.categories.values[series.cat.codes]
+            # Show the categories through the codes.
+            cat = series.values
+            return np.asarray(cat.categories), np.asarray(cat.codes), None
+        elif (isinstance(series.dtype, pd.api.extensions.ExtensionDtype)
+              and series.dtype.kind in "biuf"):
+            # A nullable type, such as Int64 or boolean.
+            if hasattr(values, "_data") and hasattr(values, "_mask"):
+                # Show the masked array's values directly, and mask the
+                # missing ones, whatever they hold.
+                return values._data, None, values._mask
+            # Otherwise, such as for Arrow-backed types, copy the values with
+            # missing ones filled in.
+            dtype = np.dtype(series.dtype.numpy_dtype)
+            return (
+                values.to_numpy(dtype=dtype, na_value=dtype.type(0)), None,
+                np.asarray(series.isna()))
+        elif isinstance(series.dtype, pd.StringDtype):
+            # Show the object array behind the strings directly, if there is
+            # one; otherwise copy to one.
+            arr = getattr(values, "_ndarray", None)
+            if arr is None or arr.dtype.kind != "O":
+                arr = np.asarray(series, dtype=object)
+            return arr, None, np.asarray(series.isna())
         else:
-            return series.values
+            return np.asarray(series), None, None
 
     if cfg["index"]["show"]:
         idx = df.index
-        if isinstance(idx, pd.core.index.MultiIndex):
-            for name, labels, levels in zip(idx.names, idx.labels, idx.levels):
-                # FIXME: Wasteful.  Handle like category columns.
-                tbl.add_index_column(name, levels.values[labels])
+        if isinstance(idx, pd.MultiIndex):
+            # Older pandas calls the codes labels.
+            codes = idx.codes if hasattr(idx, "codes") else idx.labels
+            for name, level_codes, level in zip(idx.names, codes, idx.levels):
+                tbl.add_index_column(
+                    name, np.asarray(level), codes=np.asarray(level_codes))
         else:
-            tbl.add_index_column(idx.name, get_values(idx))
+            arr, codes, mask = get_values(idx)
+            tbl.add_index_column(idx.name, arr, codes=codes, mask=mask)
 
     names = container.select_ordered(tuple(df.columns), names)
-    for name in names:
-        series = df[name]
-        arr = get_values(series)
-        tbl.add_column(series.name, arr)
+    columns = [
+        (df[name].name, ) + get_values(df[name])
+        for name in names
+    ]
+    # Choose all formatters at once.
+    fmts = tbl.get_formatters(columns)
+    for (name, arr, codes, mask), fmt in zip(columns, fmts):
+        tbl.add_column(name, arr, fmt=fmt, codes=codes, mask=mask)
 
     tbl.finish()
     return tbl
@@ -383,6 +383,29 @@ public:
 };
 
 
+/**
+ * Guard to release the GIL, if 'release' is true, for its lifetime.
+ */
+class ReleaseGIL
+{
+private:
+
+  PyThreadState* state_;
+
+public:
+
+  ReleaseGIL(bool const release=true)
+    : state_(release ? PyEval_SaveThread() : nullptr) {}
+  ~ReleaseGIL() { if (state_ != nullptr) PyEval_RestoreThread(state_); }
+
+  ReleaseGIL(ReleaseGIL const&) = delete;
+  ReleaseGIL(ReleaseGIL&&) = delete;
+  void operator=(ReleaseGIL const&) = delete;
+  void operator=(ReleaseGIL&&) = delete;
+
+};
+
+
 //==============================================================================
 
 class Object
@@ -1280,7 +1303,7 @@ private:
     try {
       throw;
     }
-    catch (EXCEPTION exc) {
+    catch (EXCEPTION const& exc) {
       throw Exception(exception_, exc.what());
     }
     catch (...) {
@@ -1,4 +1,5 @@
 import copy
+import functools
 import numpy as np
 
 from   . import string_length, palide, center, Bool, Number, String, is_fmt
@@ -33,11 +34,17 @@ DEFAULT_CFG = {
     },
     "data": {
         "max_rows"                  : "terminal",
+        "null"                      : u"",
     },
     "formatters": {
         "by_name"                   : {},
         "by_dtype"                  : {},
         "default"                   : npfmt.DEFAULT_CFG,
+        # Choose formatters for "all" rows, or only the "visible" ones.
+        "rows"                      : "all",
+        # If choosing for visible rows, also sample the hidden rows, such that
+        # at most this fraction likely don't fit.
+        "sample_error"              : None,
     },
     "header": {
         "elide": {
@@ -235,9 +242,10 @@ def _colorize(cfg):
 
 #-------------------------------------------------------------------------------
 
-def _get_formatter(name, arr, cfg):
+def _get_formatter_cfg(name, arr, cfg):
     """
-    Constructs a formatter for a named array.
+    Returns the formatter configured for a named array, or none, and the
+    formatter cfg and min width with which to choose one otherwise.
     """
     # Start with the overall default formatter configuration
     fmt_cfg = cfg["default"]
@@ -246,8 +254,8 @@ def _get_formatter(name, arr, cfg):
     # corresponding cfg dict.  If we find a formatter, return it outright.
     # Otherwise, update the formatter cfg.
     for c, k in (
-            (cfg["by_dtype"], arr.dtype.kind),
-            (cfg["by_dtype"], arr.dtype.name),
+            (cfg["by_dtype"], npfmt.get_dtype(arr).kind),
+            (cfg["by_dtype"], npfmt.get_dtype(arr).name),
             (cfg["by_name"], name),
     ):
         try:
@@ -256,7 +264,7 @@ def _get_formatter(name, arr, cfg):
             pass
         else:
             if is_fmt(val):
-                return val
+                return val, None, None
             else:
                 fmt_cfg = update_cfg(fmt_cfg, val)
 
@@ -264,7 +272,44 @@ def _get_formatter(name, arr, cfg):
     if fmt_cfg["name_width"]:
         min_width = max(min_width, string_length(name))
 
-    return npfmt.choose_formatter(arr, min_width=min_width, cfg=fmt_cfg)
+    return None, fmt_cfg, min_width
+
+
+def _get_formatters(columns, cfg):
+    """
+    Constructs formatters for named arrays, analyzing the arrays together.
+
+    :param columns:
+      Items of name, array, and ranges, which if not none are the ranges of
+      rows from which to choose.
+    """
+    fmts = [None] * len(columns)
+    choose = []
+    for i, (name, arr, ranges) in enumerate(columns):
+        fmt, fmt_cfg, min_width = _get_formatter_cfg(name, arr, cfg)
+        if fmt is None:
+            choose.append((i, arr, min_width, fmt_cfg, ranges))
+        else:
+            fmts[i] = fmt
+
+    if len(choose) > 0:
+        idxs, arrs, min_widths, cfgs, ranges = zip(*choose)
+        chosen = npfmt.choose_formatters(
+            arrs, min_widths=min_widths, cfgs=cfgs, ranges=ranges)
+        for i, fmt in zip(idxs, chosen):
+            fmts[i] = fmt
+    return fmts
+
+
+def _get_formatter(name, arr, cfg, ranges=None):
+    """
+    Constructs a formatter for a named array.
+
+    :param ranges:
+      If not none, the ranges of rows from which to choose.
+    """
+    fmt, = _get_formatters([(name, arr, ranges)], cfg)
+    return fmt
 
 
 def _get_header_position(fmt):
@@ -282,6 +327,39 @@ def _get_header_position(fmt):
         return 1  # FIXME: Constant.
 
 
+def _add_array(table, arr, fmt, null=""):
+    """
+    Adds a column for `arr` to the underlying `table`.
+
+    Arrow nulls show as `null`.
+    """
+    if npfmt.is_arrow(arr):
+        # Read the Arrow buffers directly.
+        table.add_arrow(arr, fmt, null)
+        return
+
+    name = arr.dtype.name
+    if name in {
+        "int8", "int16", "int32", "int64",
+        "uint8", "uint16", "uint32", "uint64",
+        "float32", "float64", "bool"
+    }:
+        getattr(table, "add_" + name)(arr, fmt)
+    elif name == "object":
+        table.add_str_object(arr, fmt)
+    elif arr.dtype.kind in "U":
+        table.add_ucs32(arr.dtype.itemsize, arr, fmt)
+    elif arr.dtype.kind in "S":
+        table.add_utf8(arr.dtype.itemsize, arr, fmt)
+    elif arr.dtype.kind == "M":
+        # The tick scale is carried by the formatter.
+        table.add_tick_time(arr, fmt)
+    elif arr.dtype.kind == "m":
+        table.add_tick_duration(arr, fmt)
+    else:
+        raise TypeError("unsupported dtype: {}".format(arr.dtype))
+
+
 #-------------------------------------------------------------------------------
 
 class Table:
@@ -301,33 +379,96 @@ class Table:
         self.add_string(self.__cfg["row"]["separator"]["start"])
 
 
-    def __add_array(self, arr, fmt):
-        table = self.__table
-
-        name = arr.dtype.name
-        if name in {
-            "int8", "int16", "int32", "int64",
-            "uint8", "uint16", "uint32", "uint64",
-            "float32", "float64", "bool"
-        }:
-            getattr(table, "add_" + name)(arr, fmt)
-        elif name == "object":
-            table.add_str_object(arr, fmt)
-        elif arr.dtype.kind in "U":
-            table.add_ucs32(arr.dtype.itemsize, arr, fmt)
-        elif arr.dtype.kind in "S":
-            table.add_utf8(arr.dtype.itemsize, arr, fmt)
-        elif name.startswith("datetime64"):  # FIXME: Sloppy.
-            table.add_tick_time(arr.astype("int64"), fmt)
+    def __add_array(self, arr, fmt, codes=None, mask=None):
+        null = self.__cfg["data"]["null"]
+        if codes is None:
+            _add_array(self.__table, arr, fmt, null)
         else:
-            raise TypeError("unsupported dtype: {}".format(arr.dtype))
+            # Format each category once, and look them up through the codes.
+            categories = _ext.Table()
+            _add_array(categories, arr, fmt, null)
+            self.__table.add_indexed(np.asarray(codes), categories, null)
+
+        if mask is not None:
+            # Pack the mask into a validity bitmap, with a set bit for each
+            # entry to show.
+            valid = np.packbits(
+                ~np.asarray(mask, dtype=bool), bitorder="little")
+            self.__table.set_valid(valid, null)
+
+
+    def __get_ranges(self, num_rows):
+        """
+        Returns the ranges of rows from which to choose formatters, or none for
+        all rows.
+        """
+        cfg = self.__cfg["formatters"]
+        if cfg["rows"] == "all":
+            return None
+        elif cfg["rows"] != "visible":
+            raise ValueError("rows must be \"all\" or \"visible\"")
+
+        split = self.__get_row_split(num_rows)
+        if split is None:
+            return None
+        num_rows_top, num_rows_bottom = split
+        return npfmt.sample_ranges(
+            num_rows, num_rows_top, num_rows_bottom, cfg["sample_error"])
+
+
+    def __get_sample(self, arr, codes, mask):
+        """
+        Returns the values from which to choose a formatter for a column, and
+        the ranges of them from which to choose, or none for all.
+        """
+        if codes is None and mask is not None and not np.all(mask):
+            # Choose only for the values to show.
+            arr = np.asarray(arr)
+            mask = np.asarray(mask, dtype=bool)
+            ranges = self.__get_ranges(len(arr))
+            if ranges is not None:
+                arr = npfmt.take_ranges(arr, ranges)
+                mask = npfmt.take_ranges(mask, ranges)
+            return arr[~mask], None
+
+        if npfmt.is_arrow(arr):
+            # Choose from the Arrow buffers; for a dictionary array, from the
+            # dictionary values, which don't correspond to rows.
+            _, dictionary, length = _ext.arrow_info(arr)
+            return arr, None if dictionary else self.__get_ranges(length)
+
+        arr = np.asarray(arr)
+        # Categories don't correspond to rows.
+        return arr, self.__get_ranges(len(arr)) if codes is None else None
+
+
+    def __get_formatter(self, name, arr, codes, mask):
+        fmt, = self.get_formatters([(name, arr, codes, mask)])
+        return fmt
+
+
+    def get_formatters(self, columns):
+        """
+        Chooses formatters for columns, analyzing them all together.
+
+        :param columns:
+          Items of name, array, codes, and mask, as for `add_column()`.
+        :return:
+          A formatter for each column, to pass to `add_column()`.
+        """
+        return _get_formatters(
+            [
+                (name, ) + self.__get_sample(arr, codes, mask)
+                for name, arr, codes, mask in columns
+            ],
+            self.__cfg["formatters"])
 
 
     def add_string(self, string):
         self.__table.add_string(string)
 
 
-    def add_index_column(self, name, arr, fmt=None):
+    def add_index_column(self, name, arr, fmt=None, codes=None, mask=None):
         assert self.__num_idx == len(self.__fmts), \
             "can't add index after normal column"
 
@@ -335,22 +476,37 @@ class Table:
             self.add_string(self.__cfg["row"]["separator"]["between"])
 
         if fmt is None:
-            fmt = _get_formatter(name, arr, self.__cfg["formatters"])
-        self.__add_array(arr, fmt)
+            fmt = self.__get_formatter(name, arr, codes, mask)
+        self.__add_array(arr, fmt, codes, mask)
         self.__names.append(name)
         self.__fmts.append(fmt)
         self.__num_idx += 1
 
 
-    def add_column(self, name, arr, fmt=None):
+    def add_column(self, name, arr, fmt=None, codes=None, mask=None):
+        """
+        Adds a column.
+
+        :param codes:
+          If not none, the column is categorical: `codes` are integer codes
+          into the categories `arr`, with negative codes for missing values.
+          The formatter is chosen for the categories only.
+
+        `arr` may also be an Arrow array, exported with `__arrow_c_array__`,
+        including a dictionary array.  Its buffers are read without copying.
+
+        :param mask:
+          If not none, a boolean array that is true for missing values.  These
+          show as the configured null string.
+        """
         if self.__num_idx > 0 and self.__num_idx == len(self.__fmts):
             self.add_string(self.__cfg["row"]["separator"]["index"])
         elif len(self.__fmts) > 0:
             self.add_string(self.__cfg["row"]["separator"]["between"])
 
         if fmt is None:
-            fmt = _get_formatter(name, arr, self.__cfg["formatters"])
-        self.__add_array(arr, fmt)
+            fmt = self.__get_formatter(name, arr, codes, mask)
+        self.__add_array(arr, fmt, codes, mask)
         self.__names.append(name)
         self.__fmts.append(fmt)
 
@@ -423,10 +579,11 @@ class Table:
         return self._fmt_line(self.__cfg["bottom"])
 
 
-    # FIXME: By screen (repeating header?)
-    # FIXME: Do what when it's too wide???
-
-    def _format(self):
+    def __get_row_split(self, num_rows):
+        """
+        Returns the numbers of rows to show above and below the row ellipsis,
+        or none to show all rows.
+        """
         cfg = self.__cfg
 
         num_extra_rows  = sum([
@@ -441,24 +598,41 @@ class Table:
             # FIXME
             max_rows = ansi.get_terminal_size().lines - 1
 
+        if max_rows is None or num_rows <= max_rows - num_extra_rows:
+            return None
+        else:
+            position            = cfg["row_ellipsis"]["position"]
+            num_rows_top        = int(position * max_rows)
+            num_rows_bottom     = max_rows - num_extra_rows - num_rows_top - 1
+            return num_rows_top, num_rows_bottom
+
+
+    # FIXME: By screen (repeating header?)
+    # FIXME: Do what when it's too wide???
+
+    def _format(self, render_rows):
+        """
+        Generates the parts of the table: lines, and rows from
+        `render_rows(begin, end)`.
+        """
+        cfg = self.__cfg
+
         yield self._fmt_top()
         yield self._fmt_header()
         yield self._fmt_underline()
 
         table = self.__table
         num_rows = len(table)
-        if max_rows is None or num_rows <= max_rows - num_extra_rows:
-            for i in range(len(table)):
-                yield table(i)
+        split = self.__get_row_split(num_rows)
+        if split is None:
+            yield render_rows(0, num_rows)
         else:
             cfg_ell             = cfg["row_ellipsis"]
-            num_rows_top        = int(cfg_ell["position"] * max_rows)
-            num_rows_bottom     = max_rows - num_extra_rows - num_rows_top - 1
+            num_rows_top, num_rows_bottom = split
             num_rows_skipped    = num_rows - num_rows_top - num_rows_bottom
 
             # Print rows from the top.
-            for i in range(num_rows_top):
-                yield table(i)
+            yield render_rows(0, num_rows_top)
 
             # Print the row ellipsis.
             ell = cfg_ell["format"].format(
@@ -478,19 +652,27 @@ class Table:
             yield ell_start + ell + ell_end
 
             # Print rows from the bottom.
-            for i in range(num_rows - num_rows_bottom, num_rows):
-                yield table(i)
+            yield render_rows(num_rows - num_rows_bottom, num_rows)
 
         yield self._fmt_bottom()
 
 
     def format(self):
-        yield from filter(None, self._format())
+        """
+        Generates the lines of the table, one per row.
+        """
+        render_lines = functools.partial(self.__table.render_rows, lines=True)
+        for part in self._format(render_lines):
+            if isinstance(part, list):
+                yield from part
+            elif part:
+                yield part
 
 
     def print(self, print=print):
-        for line in self.format():
-            print(line)
+        # Rows are rendered in blocks, joined by newlines.
+        for block in filter(None, self._format(self.__table.render_rows)):
+            print(block)
 
 
 
@@ -506,13 +688,21 @@ def from_arrays(arrs, cfg=DEFAULT_CFG):
     except AttributeError:
         pass
 
+    # FIXME: Since Table doesn't support S and U arrays, convert these to
+    # objects for now.
+    arrs = [
+        (name, arr.astype(object) if arr.dtype.kind in "SU" else arr)
+        for name, arr in arrs
+    ]
+
     tbl = Table(cfg)
-    for name, arr in arrs:
-        # FIXME: Since Table doesn't support S and U arrays, convert these
-        # to objects for now.
-        if arr.dtype.kind in "SU":
-            arr = arr.astype(object)
-        tbl.add_column(name, arr)
+    # Choose all formatters at once.
+    fmts = tbl.get_formatters([
+        (name, arr, None, None)
+        for name, arr in arrs
+    ])
+    for (name, arr), fmt in zip(arrs, fmts):
+        tbl.add_column(name, arr, fmt=fmt)
     tbl.finish()
     return tbl
 
@@ -0,0 +1,186 @@
+import ctypes
+
+import numpy as np
+import pytest
+
+import fixfmt
+from   fixfmt import _ext, npfmt
+from   fixfmt.table import Table
+
+#-------------------------------------------------------------------------------
+
+# Minimal Arrow C data interface structs, so we don't depend on pyarrow.
+
+class ArrowSchema(ctypes.Structure):
+    pass
+
+ArrowSchema._fields_ = [
+    ("format", ctypes.c_char_p),
+    ("name", ctypes.c_char_p),
+    ("metadata", ctypes.c_char_p),
+    ("flags", ctypes.c_int64),
+    ("n_children", ctypes.c_int64),
+    ("children", ctypes.c_void_p),
+    ("dictionary", ctypes.POINTER(ArrowSchema)),
+    ("release", ctypes.c_void_p),
+    ("private_data", ctypes.c_void_p),
+]
+
+
+class ArrowArray(ctypes.Structure):
+    pass
+
+ArrowArray._fields_ = [
+    ("length", ctypes.c_int64),
+    ("null_count", ctypes.c_int64),
+    ("offset", ctypes.c_int64),
+    ("n_buffers", ctypes.c_int64),
+    ("n_children", ctypes.c_int64),
+    ("buffers", ctypes.POINTER(ctypes.c_void_p)),
+    ("children", ctypes.c_void_p),
+    ("dictionary", ctypes.POINTER(ArrowArray)),
+    ("release", ctypes.c_void_p),
+    ("private_data", ctypes.c_void_p),
+]
+
+# The structs are owned by the exporter, so release does nothing.
+RELEASE = ctypes.CFUNCTYPE(None, ctypes.c_void_p)(lambda ptr: None)
+
+PyCapsule_New = ctypes.pythonapi.PyCapsule_New
+PyCapsule_New.restype = ctypes.py_object
+PyCapsule_New.argtypes = (ctypes.c_void_p, ctypes.c_char_p, ctypes.c_void_p)
+
+
+class Exporter:
+    """
+    Exports buffers as an Arrow array through `__arrow_c_array__`.  Must outlive
+    the capsules.  Converts to `values` for NumPy, if given.
+    """
+
+    def __init__(self, format, length, buffers, null_count=0, offset=0,
+                 dictionary=None, values=None):
+        self.buffers = buffers
+        self.values = values
+        self.dictionary = dictionary
+        ptrs = [None if b is None else b.ctypes.data for b in buffers]
+        self.ptrs = (ctypes.c_void_p * len(buffers))(*ptrs)
+        self.schema = ArrowSchema(
+            format=format, release=ctypes.cast(RELEASE, ctypes.c_void_p))
+        self.array = ArrowArray(
+            length=length, null_count=null_count, offset=offset,
+            n_buffers=len(buffers), buffers=self.ptrs,
+            release=ctypes.cast(RELEASE, ctypes.c_void_p))
+        if dictionary is not None:
+            self.schema.dictionary = ctypes.pointer(dictionary.schema)
+            self.array.dictionary = ctypes.pointer(dictionary.array)
+
+
+    def __arrow_c_array__(self, requested_schema=None):
+        return (
+            PyCapsule_New(ctypes.addressof(self.schema), b"arrow_schema", None),
+            PyCapsule_New(ctypes.addressof(self.array), b"arrow_array", None),
+        )
+
+
+    def __array__(self, dtype=None, copy=None):
+        if self.values is None:
+            raise TypeError("no conversion to NumPy")
+        return self.values
+
+
+def bitmap(valid):
+    return np.packbits(np.array(valid, dtype=bool), bitorder="little")
+
+
+def strings(words):
+    data = "".join(words).encode()
+    offsets = np.cumsum([0] + [len(w.encode()) for w in words], dtype="int32")
+    return Exporter(
+        b"u", len(words), [None, offsets, np.frombuffer(data, dtype="uint8")])
+
+
+#-------------------------------------------------------------------------------
+
+def test_int():
+    arr = Exporter(
+        b"l", 3,
+        [bitmap([1, 1, 0, 1]), np.array([5, 6, 7, 8], dtype="int64")],
+        null_count=1, offset=1)
+    tbl = _ext.Table()
+    tbl.add_arrow(arr, fixfmt.Number(2), null="-")
+    assert tbl.length == 3
+    assert [tbl(i) for i in range(3)] == ["  6", "-  ", "  8"]
+
+
+def test_bool():
+    arr = Exporter(b"b", 4, [None, bitmap([1, 0, 0, 1])])
+    tbl = _ext.Table()
+    tbl.add_arrow(arr, fixfmt.Bool("yes", "no"))
+    assert tbl.render_rows(0, 4) == "yes\nno \nno \nyes"
+
+
+def test_dictionary():
+    arr = Exporter(
+        b"c", 4, [bitmap([1, 1, 0, 1]), np.array([1, 0, 0, 1], dtype="int8")],
+        null_count=1, dictionary=strings(["red", "blue"]))
+    tbl = Table()
+    tbl.add_column("color", arr)
+    tbl.finish()
+    assert list(tbl.format())[2:] == ["blue", "red ", "    ", "blue"]
+
+
+def test_table_null():
+    from fixfmt.table import DEFAULT_CFG, update_cfg
+
+    # Nulls show as the configured null string.
+    cfg = update_cfg(DEFAULT_CFG, {"data": {"null": "NA"}})
+    ints = Exporter(
+        b"l", 3,
+        [bitmap([1, 0, 1]), np.array([10, 20, 30], dtype="int64")],
+        null_count=1)
+    colors = Exporter(
+        b"c", 3, [bitmap([0, 1, 1]), np.array([1, 0, 1], dtype="int8")],
+        null_count=1, dictionary=strings(["red", "blue"]))
+    tbl = Table(cfg)
+    tbl.add_column("x", ints)
+    tbl.add_column("color", colors)
+    tbl.finish()
+    assert list(tbl.format())[2:] == ["10 NA  ", "NA red ", "30 blue"]
+
+
+def test_choose_number():
+    # The null slot's value doesn't widen the formatter.
+    arr = Exporter(
+        b"g", 3,
+        [bitmap([1, 1, 0, 1]), np.array([1e9, -1.5, 123456, 2.25])],
+        null_count=1, offset=1)
+    fmt = npfmt.choose_formatter(arr)
+    assert fmt.size == 1
+    assert fmt.precision == 2
+    assert fmt.sign == "-"
+
+
+def test_choose_string():
+    fmt = npfmt.choose_formatter(strings(["a", "caf\u00e9", "bc"]))
+    assert fmt.size == 4
+
+    arr = Exporter(
+        b"i", 3, [None, np.array([0, 0, 1], dtype="int32")],
+        dictionary=strings(["x", "wxyz"]))
+    assert npfmt.get_dtype(arr).kind == "U"
+    fmts = npfmt.choose_formatters([arr, np.arange(3)])
+    assert fmts[0].size == 4
+    assert fmts[1].size == 1
+
+
+def test_wrong_format():
+    arr = strings(["foo"])
+    tbl = _ext.Table()
+    with pytest.raises(ValueError):
+        tbl.add_arrow(arr, fixfmt.Number(3))
+    with pytest.raises(TypeError):
+        tbl.add_arrow(np.arange(3), fixfmt.Number(3))
+    with pytest.raises(TypeError):
+        npfmt.choose_formatter(Exporter(b"+s", 0, []))
+
+
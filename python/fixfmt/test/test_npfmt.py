@@ -1,4 +1,5 @@
 import numpy as np
+import pytest
 
 import fixfmt
 import fixfmt.npfmt
@@ -85,3 +86,302 @@ def test_choose_formatter_date():
     assert fmt.width == len(fmt(t1.astype(int)))
 
 
+def test_analyze_threads():
+    from fixfmt._ext import analyze_double
+
+    arr = np.round(np.random.default_rng(0).uniform(-1e3, 1e3, 500000), 3)
+    arr[400000] = np.nan
+    one, four = (analyze_double(arr, 16, num_threads=n) for n in (1, 4))
+    assert one == four
+    assert one[:4] == (True, False, False, 499999)
+    assert one[-1] == 3
+    assert analyze_double(arr[::3], 16, num_threads=4)[-1] == 3
+
+
+def test_analyze_int():
+    from fixfmt import _ext
+
+    arr = np.array([5, -120, 17], dtype="int8")
+    assert _ext.analyze_int8(arr) == (3, -120, 17, 3)
+    arr = np.array([0, 2 ** 64 - 1], dtype="uint64")
+    assert _ext.analyze_uint64(arr) == (2, 0, 2 ** 64 - 1, 20)
+    assert _ext.analyze_int32(np.arange(10, dtype="int32")[::3]) == (4, 0, 9, 1)
+    assert _ext.analyze_int16(np.array([], dtype="int16"))[0] == 0
+
+
+def test_choose_formatter_int_dtypes():
+    for dtype in ("int8", "int16", "int32", "int64",
+                  "uint8", "uint16", "uint32", "uint64"):
+        info = np.iinfo(dtype)
+        arr = np.array([info.min, 0, info.max], dtype=dtype)
+        fmt = fixfmt.npfmt.choose_formatter(arr)
+        assert fmt.size == len(str(info.max))
+        assert fmt.sign == ("-" if info.min < 0 else " ")
+
+
+def test_choose_formatter_byte_order():
+    # Non-native arrays are converted before they're analyzed.
+    for dtype in (">i4", ">u8", ">f8", ">U4"):
+        arr = np.array([1234, 5, 60000], dtype=dtype)
+        native = arr.astype(arr.dtype.newbyteorder("="))
+        ranges = np.array([[0, 2]])
+        for r in (None, ranges):
+            fmt = fixfmt.npfmt.choose_formatter(arr, ranges=r)
+            assert repr(fmt) == repr(
+                fixfmt.npfmt.choose_formatter(native, ranges=r))
+        fmts = fixfmt.npfmt.choose_formatters([arr], ranges=[ranges])
+        assert repr(fmts) == repr(
+            fixfmt.npfmt.choose_formatters([native], ranges=[ranges]))
+    assert fixfmt.npfmt.choose_formatter(np.array([-7], dtype=">i8")).size == 1
+
+
+def test_choose_formatter_scaled():
+    cfg = dict(fixfmt.npfmt.DEFAULT_CFG["number"], scale=(1000, "k"))
+
+    arr = np.array([1500.0, -250.0, 12345.0])
+    copy = arr.copy()
+    fmt = fixfmt.npfmt.choose_formatter_number(arr, cfg=cfg)
+    assert (arr == copy).all()
+    assert fmt.size == 2
+    assert fmt.precision == 3
+    assert fmt.sign == "-"
+
+    # Integer arrays, which can't be divided in place.
+    arr = np.array([1500, 250, 12345], dtype="int32")
+    fmt = fixfmt.npfmt.choose_formatter_number(arr, cfg=cfg)
+    assert (arr == [1500, 250, 12345]).all()
+    assert fmt.size == 2
+    assert fmt.precision == 3
+    assert fmt.sign == " "
+    assert fmt(12345) == "12.345k"
+
+
+def test_analyze_scaled():
+    from fixfmt import _ext
+
+    arr = np.arange(-50, 50, dtype="int16")
+    assert _ext.analyze_scaled(arr, 10, 16) == (
+        False, False, False, 100, -5.0, 4.9, 1)
+    assert (_ext.analyze_scaled(arr.astype("float32"), 10, 8)
+            == _ext.analyze_float(arr.astype("float32") / 10, 8))
+    assert _ext.analyze_scaled(arr[::7], 0.5, 16)[-1] == 0
+
+
+def test_analyze_strings():
+    from fixfmt import _ext
+    from fixfmt import string_length
+
+    words = ["", "x", "hello", "café", "……", "\x1b[32mgreen\x1b[m",
+             "\U0001f600 smile"]
+    expected = max(string_length(w) for w in words)
+    for arr in (np.array(words), np.array(words, dtype=object),
+                np.array([w.encode() for w in words])):
+        kind, itemsize = arr.dtype.kind, arr.dtype.itemsize
+        assert _ext.analyze_strings(arr, kind, itemsize, 64) == expected
+        assert _ext.analyze_strings(arr, kind, itemsize, 3) == 3
+        assert _ext.analyze_strings(arr[:2], kind, itemsize, 64) == 1
+        assert _ext.analyze_strings(arr[::2], kind, itemsize, 64) == 7
+        assert _ext.analyze_strings(arr[:0], kind, itemsize, 64) == 0
+
+    # Objects are measured as strings.
+    arr = np.array([None, 12345, 1.5], dtype=object)
+    assert _ext.analyze_strings(arr, "O", arr.dtype.itemsize, 64) == 5
+
+
+def test_choose_formatter_str():
+    arr = np.array(["foo", "……", "bazinga"])
+    fmt = fixfmt.npfmt.choose_formatter(arr)
+    assert isinstance(fmt, fixfmt.String)
+    assert fmt.size == 7
+    fmt = fixfmt.npfmt.choose_formatter(arr.astype(object), min_width=10)
+    assert fmt.size == 10
+
+
+def test_sample_ranges():
+    from fixfmt.npfmt import sample_ranges
+
+    assert sample_ranges(100, 10, 5).tolist() == [[0, 10], [95, 100]]
+    assert sample_ranges(10, 8, 5).tolist() == [[0, 8], [8, 10]]
+    assert sample_ranges(100, 10, 5, error=0).tolist() == [
+        [0, 10], [10, 95], [95, 100]]
+
+    # One row from each stratum.
+    ranges = sample_ranges(10 ** 9, 10, 5, error=0.01)
+    rows = ranges[1 : -1, 0]
+    assert len(rows) == 459
+    assert (ranges[1 : -1, 1] == rows + 1).all()
+    assert (np.diff(rows) > 0).all()
+    assert rows[0] >= 10 and rows[-1] < 10 ** 9 - 5
+
+
+def test_choose_formatter_ranges():
+    arr = np.arange(1000, dtype=float)
+    arr[500] = 0.125
+    ranges = np.array([[0, 10], [990, 1000]])
+    fmt = fixfmt.npfmt.choose_formatter(arr, ranges=ranges)
+    assert fmt.size == 3
+    assert fmt.precision is None
+    fmt = fixfmt.npfmt.choose_formatter(arr.astype("int16"), ranges=ranges)
+    assert fmt.size == 3
+    fmt = fixfmt.npfmt.choose_formatter(arr, ranges=np.array([[495, 505]]))
+    assert fmt.precision == 3
+
+    strs = np.array(["a", "bbbb", "cc"])
+    fmt = fixfmt.npfmt.choose_formatter(strs, ranges=np.array([[2, 3]]))
+    assert fmt.size == 2
+
+    times = np.array(["2020-01-01T00:00:00.5", "2020-01-01"], "datetime64[ms]")
+    fmt = fixfmt.npfmt.choose_formatter(times, ranges=np.array([[1, 2]]))
+    assert fmt.precision == -1
+
+
+def test_analyze_ranges():
+    from fixfmt import _ext
+
+    arr = np.array([1.5, 1000.0, -2.25, np.nan])
+    ranges = np.array([[0, 1], [2, 4]])
+    assert _ext.analyze_double(arr, 16, ranges=ranges) == (
+        True, False, False, 2, -2.25, 1.5, 2)
+    assert _ext.analyze_int64(np.arange(10), ranges=ranges) == (3, 0, 3, 1)
+    assert _ext.analyze_scaled(arr, 10, 16, ranges=ranges[: 1])[-1] == 2
+    objs = np.array(["a", "bbbb", "cc", "d"], dtype=object)
+    assert _ext.analyze_strings(objs, "O", 8, 64, ranges=ranges) == 2
+    with pytest.raises(ValueError):
+        _ext.analyze_double(arr, 16, ranges=np.array([[0, 5]]))
+    with pytest.raises(TypeError):
+        _ext.analyze_double(arr, 16, ranges=np.array([0, 1]))
+
+
+def test_stats_chunks():
+    from fixfmt.npfmt import make_stats, choose_formatter
+
+    arr = np.round(np.random.default_rng(1).uniform(-1e4, 1e4, 100000), 2)
+    arr[70000] = np.inf
+    whole = choose_formatter(arr)
+
+    # Analyze chunks incrementally, and separately then merged.
+    stats = make_stats(arr.dtype)
+    for i in range(0, len(arr), 30000):
+        stats.update(arr[i : i + 30000])
+    other = make_stats(arr.dtype)
+    for i in range(0, len(arr), 40000):
+        chunk = make_stats(arr.dtype)
+        chunk.update(arr[i : i + 40000], num_threads=2)
+        other.merge(chunk)
+    for s in (stats, other):
+        assert s.num == 99999
+        assert s.has_pos_inf and not s.has_nan
+        assert s.precision == 2
+        assert not s.integer
+        fmt = choose_formatter(None, stats=s)
+        assert (fmt.size, fmt.precision, fmt.sign) == (
+            whole.size, whole.precision, whole.sign)
+
+    ints = np.arange(-5, 12345, dtype="int32")
+    stats = make_stats(ints.dtype)
+    stats.update(ints[: 100])
+    stats.update(ints[100 :], ranges=np.array([[0, 10], [12000, 12250]]))
+    assert stats.integer
+    assert (stats.num, stats.min, stats.max, stats.digits) == (
+        360, -5, 12344, 5)
+    assert choose_formatter(None, stats=stats).size == 5
+
+    # 64-bit integer bounds are exact, also merged across signedness.
+    big = np.array([2**53 + 1, -(2**63)], dtype="int64")
+    stats = make_stats(big.dtype)
+    stats.update(big)
+    assert (stats.min, stats.max) == (-(2**63), 2**53 + 1)
+    stats.update(np.array([2**64 - 1, 2**63 + 1], dtype="uint64"))
+    assert (stats.min, stats.max) == (-(2**63), 2**64 - 1)
+    stats = make_stats("uint64")
+    stats.update(np.array([2**63 + 1, 2**64 - 1], dtype="uint64"))
+    assert (stats.min, stats.max) == (2**63 + 1, 2**64 - 1)
+
+    strs = np.array(["a", "bbbb", "cc"])
+    stats = make_stats(strs.dtype)
+    stats.update(strs[: 1])
+    stats.update(strs.astype(object)[1 :])
+    assert (stats.num, stats.size) == (3, 4)
+    assert choose_formatter(None, stats=stats).size == 4
+
+
+def test_stats_cfg():
+    from fixfmt.npfmt import DEFAULT_CFG, make_stats, choose_formatter
+
+    cfg = dict(
+        DEFAULT_CFG, number=dict(DEFAULT_CFG["number"], scale=(1000, "k")))
+    stats = make_stats("int64", cfg)
+    stats.update(np.array([1500, 250, 12345]))
+    assert not stats.integer
+    fmt = choose_formatter(None, cfg=cfg, stats=stats)
+    assert (fmt.size, fmt.precision) == (2, 3)
+
+    # Stats analyzed differently can't be merged or used.
+    with pytest.raises(ValueError):
+        make_stats("float64").merge(stats)
+    with pytest.raises(ValueError):
+        choose_formatter(None, stats=stats)
+    with pytest.raises(TypeError):
+        make_stats("float64").update(np.array(["x"]))
+    with pytest.raises(TypeError):
+        make_stats("datetime64[ns]")
+
+
+def test_analyze_columns():
+    from fixfmt import _ext
+    from fixfmt.npfmt import make_stats
+
+    rng = np.random.default_rng(2)
+    arrs = [
+        np.round(rng.uniform(-100, 100, 200000), 1),
+        rng.integers(0, 1000, 50000).astype("uint16"),
+        np.array(["x", "hello", "……"]),
+        np.array(["ab", 12345, None], dtype=object),
+        np.arange(10, dtype="float32")[::2],
+    ]
+    stats = [make_stats(a.dtype) for a in arrs]
+    ranges = [None, np.array([[0, 10]]), None, None, None]
+    _ext.analyze_columns(list(zip(stats, arrs, ranges)), num_threads=3)
+
+    # Same as analyzing each separately.
+    for s, arr, r in zip(stats, arrs, ranges):
+        expected = make_stats(arr.dtype)
+        expected.update(arr, ranges=r)
+        for attr in ("num", "size", "min", "max", "precision", "digits"):
+            assert getattr(s, attr, None) == getattr(expected, attr, None)
+    assert stats[1].num == 10
+    assert stats[3].size == 5
+
+    # Chunks of one array into the same stats.
+    s = make_stats(arrs[0].dtype)
+    _ext.analyze_columns(
+        [(s, arrs[0][: 1000], None), (s, arrs[0][1000 :], None)])
+    assert (s.num, s.precision) == (200000, 1)
+
+    _ext.analyze_columns([])
+    with pytest.raises(TypeError):
+        _ext.analyze_columns([(stats[0], arrs[2], None)])
+    with pytest.raises(TypeError):
+        _ext.analyze_columns([(None, arrs[0], None)])
+
+
+def test_choose_formatters():
+    from fixfmt.npfmt import DEFAULT_CFG, choose_formatter, choose_formatters
+
+    arrs = [
+        np.array([1.5, -20.25]),
+        np.arange(1000),
+        np.array([True, False]),
+        np.array(["foo", "bazinga"], dtype=object),
+        np.array(["2020-01-01"], dtype="datetime64[s]"),
+    ]
+    fixed = dict(DEFAULT_CFG, string=dict(DEFAULT_CFG["string"], size=4))
+    cfgs = [DEFAULT_CFG] * 4 + [fixed]
+    fmts = choose_formatters(arrs, min_widths=[0, 6, 0, 0, 0], cfgs=cfgs)
+    for fmt, arr, min_width, cfg in zip(fmts, arrs, [0, 6, 0, 0, 0], cfgs):
+        expected = choose_formatter(arr, min_width, cfg)
+        assert type(fmt) is type(expected)
+        assert fmt.width == expected.width
+    assert fmts[0].precision == 2
+    assert fmts[1].width == 6
+    assert fmts[3].size == 7
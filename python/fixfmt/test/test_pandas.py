@@ -0,0 +1,101 @@
+import numpy as np
+import pytest
+
+pd = pytest.importorskip("pandas")
+
+from   fixfmt.pandas import from_dataframe
+from   fixfmt.table import DEFAULT_CFG, update_cfg
+
+CFG = update_cfg(DEFAULT_CFG, {"data": {"max_rows": None}})
+
+#-------------------------------------------------------------------------------
+
+def test_categorical():
+    values = np.array(["apple", "pear", None, "fig", "pear"], dtype=object)
+    df = pd.DataFrame({
+        "c": pd.Categorical(values),
+        "x": np.arange(5),
+        "f": pd.Categorical([1.5, 2.25, 1.5, np.nan, 2.25]),
+    })
+    lines = list(from_dataframe(df, CFG).format())
+    assert lines[2:] == [
+        "0 | apple 0 1.50",
+        "1 | pear  1 2.25",
+        "2 |       2 1.50",
+        "3 | fig   3     ",
+        "4 | pear  4 2.25",
+    ]
+
+
+def test_categorical_index():
+    df = pd.DataFrame(
+        {"x": np.arange(4)},
+        index=pd.CategoricalIndex(["b", "a", "b", "b"], name="i"))
+    lines = list(from_dataframe(df, CFG).format())
+    assert lines[2:] == [
+        "b | 0",
+        "a | 1",
+        "b | 2",
+        "b | 3",
+    ]
+
+
+def test_multi_index():
+    idx = pd.MultiIndex.from_product(
+        [["north", "south"], [10, 20, 30]], names=["region", "n"])
+    df = pd.DataFrame({"x": np.arange(6) / 2}, index=idx)
+    lines = list(from_dataframe(df, CFG).format())
+    assert lines[2:] == [
+        "north 10 | 0.0",
+        "north 20 | 0.5",
+        "north 30 | 1.0",
+        "south 10 | 1.5",
+        "south 20 | 2.0",
+        "south 30 | 2.5",
+    ]
+
+
+def test_nullable():
+    df = pd.DataFrame({
+        "i": pd.array([1, None, 300, None], dtype="Int64"),
+        "b": pd.array([True, False, None, True], dtype="boolean"),
+        "s": pd.array(["ab", None, "cde", "f"], dtype="string"),
+    })
+    cfg = update_cfg(CFG, {"data": {"null": "-"}})
+    lines = list(from_dataframe(df, cfg).format())
+    assert lines[2:] == [
+        "0 |   1 true  ab ",
+        "1 | -   false -  ",
+        "2 | 300 -     cde",
+        "3 | -   true  f  ",
+    ]
+
+
+def test_nullable_no_copy():
+    df = pd.DataFrame({"i": pd.array([1, None, 3], dtype="Int64")})
+    tbl = from_dataframe(df, CFG)
+    # The table reads the masked array's values directly.
+    df["i"].array._data[2] = 7
+    assert list(tbl.format())[2:] == ["0 | 1", "1 |  ", "2 | 7"]
+
+
+def test_wide():
+    from fixfmt.table import Table
+
+    rng = np.random.default_rng(0)
+    df = pd.DataFrame({
+        f"c{i}": np.round(rng.uniform(-10 ** i, 10 ** i, 100), i % 3)
+        for i in range(40)
+    })
+    df["n"] = np.arange(100, dtype="int16")
+    df["s"] = ["x" * (i % 7) for i in range(100)]
+    lines = list(from_dataframe(df, CFG).format())
+
+    # Same as choosing the formatters one column at a time.
+    tbl = Table(CFG)
+    tbl.add_index_column(None, np.asarray(df.index))
+    for name in df.columns:
+        tbl.add_column(name, np.asarray(df[name]))
+    tbl.finish()
+    assert lines == list(tbl.format())
+    assert len(lines) == 102
@@ -1,6 +1,7 @@
 import numpy as np
+import pytest
 
-from   fixfmt.table import Table
+from   fixfmt.table import Table, DEFAULT_CFG, update_cfg
 
 #-------------------------------------------------------------------------------
 
@@ -32,3 +33,404 @@ def test_array_dtypes():
     tbl.print()
 
 
+def test_tick_time_no_copy():
+    import fixfmt
+    from fixfmt import _ext
+
+    arr = np.array(
+        ["2019-11-01T02:37:51", "2019-11-02T00:00:00"], dtype="datetime64[s]")
+    tbl = _ext.Table()
+    tbl.add_tick_time(arr, fixfmt.TickTime(1, -1))
+    assert tbl(1) == "2019-11-02T00:00:00+00:00"
+    # The table reads the array's data directly.
+    arr[1] = np.datetime64("2020-01-01T12:00:00")
+    assert tbl(1) == "2020-01-01T12:00:00+00:00"
+
+
+def test_render_rows():
+    import fixfmt
+    from fixfmt import _ext
+
+    table = _ext.Table()
+    table.add_int64(np.arange(1000), fixfmt.Number(3))
+    table.add_string(" ")
+    table.add_float64(np.arange(1000) / 8, fixfmt.Number(3, 3))
+    assert table.render_rows(0, 1000) == "\n".join(
+        table(i) for i in range(1000))
+    assert table.render_rows(998, 1000) == table(998) + "\n" + table(999)
+    assert table.render_rows(5, 5) == ""
+    with pytest.raises(IndexError):
+        table.render_rows(0, 1001)
+
+    # Or as a list of rows.
+    assert table.render_rows(10, 20, lines=True) == [
+        table(i) for i in range(10, 20) ]
+    assert table.render_rows(5, 5, lines=True) == []
+
+
+def test_format_lines():
+    import fixfmt.npfmt
+
+    cfg = update_cfg(DEFAULT_CFG, {"data": {"max_rows": None}})
+    tbl = Table(cfg)
+    tbl.add_column("x", np.arange(1000))
+    tbl.finish()
+
+    # Header, underline, and one line per row.
+    lines = list(tbl.format())
+    assert len(lines) == 1002
+    fmt = fixfmt.npfmt.choose_formatter(np.arange(1000))
+    assert lines[2:] == [ fmt(i) for i in range(1000) ]
+
+
+def test_format_newlines():
+    # A cell with a newline is still one row.
+    tbl = Table()
+    tbl.add_column("s", np.array(["a\nb", "cd", "e"], dtype=object))
+    tbl.add_column("x", np.arange(3))
+    tbl.finish()
+    assert list(tbl.format())[2:] == ["a\nb 0", "cd  1", "e   2"]
+
+
+def test_needs_python():
+    import fixfmt
+    from fixfmt import _ext
+
+    tbl = _ext.Table()
+    tbl.add_int64(np.arange(10), fixfmt.Number(1))
+    tbl.add_ucs32(12, np.array(["foo", "bar"] * 5), fixfmt.String(3))
+    assert not tbl.needs_python
+
+    tbl.add_str_object(
+        np.array(["foo", 42] * 5, dtype=object), fixfmt.String(3))
+    assert tbl.needs_python
+
+    # Such a table renders with the GIL held, on one thread.
+    assert tbl.render_rows(0, 10, 4) == "\n".join( tbl(i) for i in range(10) )
+    assert tbl(1) == " 1bar42 "
+
+
+def test_render_threads():
+    from concurrent.futures import ThreadPoolExecutor
+
+    tbl = Table()
+    tbl.add_column("x", np.arange(100000))
+    tbl.add_column("y", np.arange(100000) / 7)
+    tbl.add_column("s", np.array(["foo", "bar", "baz"] * 33333 + ["bif"]))
+    tbl.finish()
+
+    # Render the table from several threads at once.
+    expected = list(tbl.format())
+    with ThreadPoolExecutor(4) as executor:
+        results = list(executor.map(lambda _: list(tbl.format()), range(8)))
+    assert all( r == expected for r in results )
+
+    # Each of which may itself render in parallel.
+    import fixfmt
+    from fixfmt import _ext
+
+    table = _ext.Table()
+    table.add_int64(np.arange(100000), fixfmt.Number(6))
+    table.add_string(" ")
+    table.add_float64(np.arange(100000) / 7, fixfmt.Number(5, 3))
+    expected = table.render_rows(0, 100000)
+    with ThreadPoolExecutor(4) as executor:
+        results = list(executor.map(
+            lambda n: table.render_rows(0, 100000, n % 3 + 1), range(8)))
+    assert all( r == expected for r in results )
+
+
+def test_render_parallel():
+    import fixfmt
+    from fixfmt import _ext
+
+    length = 5000
+    table = _ext.Table()
+    table.add_int64(np.arange(length), fixfmt.Number(4))
+    table.add_string(" ")
+    table.add_float64(np.arange(length) / 3, fixfmt.Number(4, 2))
+    expected = table.render_rows(0, length)
+    for num_threads in (0, 2, 7):
+        assert table.render_rows(0, length, num_threads) == expected
+    assert table.render_rows(3, 1030, num_threads=3) == table.render_rows(
+        3, 1030)
+    with pytest.raises(ValueError):
+        table.render_rows(0, length, -1)
+
+    # A table of Python objects renders on one thread.
+    table.add_str_object(
+        np.array(["x", 3] * (length // 2), dtype=object), fixfmt.String(3))
+    assert table.render_rows(0, 4, 4) == table.render_rows(0, 4)
+
+
+def test_change_while_rendering():
+    import fixfmt
+    from fixfmt import _ext
+
+    class Obj:
+        def __str__(self):
+            # Changes the table from within its own render.
+            tbl.add_string("!")
+            return "obj"
+
+    tbl = _ext.Table()
+    tbl.add_str_object(np.array([Obj()], dtype=object), fixfmt.String(4))
+    with pytest.raises(RuntimeError):
+        tbl(0)
+    with pytest.raises(RuntimeError):
+        tbl.render_rows(0, 1)
+
+    # Once no render is in progress, the table may change.
+    tbl.add_string("|")
+    assert tbl.width == 5
+
+def test_strided():
+    # Columns of a 2-D array, and fields of a packed record array, in which the
+    # times and objects aren't aligned.
+    mat = np.arange(24, dtype="float64").reshape(6, 4) / 4
+    rec = np.array(
+        [(i, "abc"[i % 3] * (i % 4), np.datetime64(i * 61, "s"), str(i))
+         for i in range(6)],
+        dtype=[("i", "int16"), ("s", "S3"), ("t", "M8[s]"), ("o", "O")])
+    codes = np.array([[0, 1], [1, 0], [-1, 0]] * 2, dtype="int8")
+
+    tbl = Table()
+    tbl.add_column("m1", mat[:, 1])
+    tbl.add_column("m3", mat[::-1, 3])
+    tbl.add_column("i", rec["i"])
+    tbl.add_column("s", rec["s"])
+    tbl.add_column("t", rec["t"])
+    tbl.add_column("o", rec["o"])
+    tbl.add_column("u", np.array(["x", "yy"] * 6)[::2])
+    tbl.add_column("c", np.array(["foo", "bar"]), codes=codes[:, 0])
+    tbl.finish()
+
+    lines = list(tbl.format())
+    assert lines[2:] == [
+        "0.25 5.75 0     1970-01-01T00:00:00+00:00 0 x foo",
+        "1.25 4.75 1 b   1970-01-01T00:01:01+00:00 1 x bar",
+        "2.25 3.75 2 cc  1970-01-01T00:02:02+00:00 2 x    ",
+        "3.25 2.75 3 aaa 1970-01-01T00:03:03+00:00 3 x foo",
+        "4.25 1.75 4     1970-01-01T00:04:04+00:00 4 x bar",
+        "5.25 0.75 5 c   1970-01-01T00:05:05+00:00 5 x    ",
+    ]
+
+    # The table reads the arrays directly.
+    mat[2, 1] = 9
+    rec["i"][2] = 7
+    # Skip the header and underline.
+    lines = list(tbl.format())
+    assert lines[2 + 2].startswith("9.00 3.75 7 ")
+
+
+def test_codes_null():
+    # Negative codes show as the configured null string.
+    cfg = update_cfg(DEFAULT_CFG, {"data": {"null": "NA"}})
+    tbl = Table(cfg)
+    codes = np.array([1, -1, 0], dtype="int16")
+    tbl.add_column("c", np.array(["foo", "bar"]), codes=codes)
+    tbl.finish()
+    assert list(tbl.format())[2:] == ["bar", "NA ", "foo"]
+
+
+def test_mask():
+    import fixfmt
+    from fixfmt import _ext
+
+    arr = np.arange(200) * 1.5
+    mask = arr % 9 < 2
+    cfg = update_cfg(DEFAULT_CFG, {"data": {"max_rows": None, "null": "NA"}})
+    tbl = Table(cfg)
+    tbl.add_column("x", arr, mask=mask)
+    tbl.finish()
+    lines = list(tbl.format())[2:]
+    assert len(lines) == 200
+    assert lines[:4] == ["NA   ", "NA   ", "  3.0", "  4.5"]
+    assert lines[6] == "NA   "
+    assert lines[131] == "196.5"
+
+    # A bitmap at an offset, for the most recent column.
+    table = _ext.Table()
+    table.add_int64(np.arange(4), fixfmt.Number(1))
+    table.set_valid(np.array([0b01010000], dtype="uint8"), "-", offset=3)
+    assert table.render_rows(0, 4) == "- \n 1\n- \n 3"
+    with pytest.raises(ValueError):
+        table.set_valid(np.array([0xff], dtype="uint8"), offset=5)
+    table.add_string("|")
+    with pytest.raises(ValueError):
+        table.set_valid(np.array([0xff], dtype="uint8"))
+
+
+def test_bool_bits():
+    import fixfmt
+    from fixfmt import _ext
+
+    arr = np.arange(100) % 3 == 0
+    fmt = fixfmt.Bool("yes", "no")
+    bits = _ext.Table()
+    bits.add_bool_bits(np.packbits(arr, bitorder="little"), 97, fmt, 3)
+    table = _ext.Table()
+    table.add_bool(arr[3:], fmt)
+    assert bits.render_rows(0, 97) == table.render_rows(0, 97)
+    with pytest.raises(ValueError):
+        bits.add_bool_bits(np.packbits(arr), 102, fmt, 3)
+
+
+def test_str_object():
+    import fixfmt
+    from fixfmt import _ext
+
+    class Obj:
+        def __str__(self):
+            return "obj"
+
+    class Str(str):
+        def __str__(self):
+            return "sub"
+
+    objs = [
+        "abc", "d\xe9f", "\u2714", None, 0, -12345, 2**70, True, 1.5, 0.1,
+        1e20, -0.0, float("nan"), Obj(), Str("xyz"), b"ab",
+    ]
+    arr = np.array(objs, dtype=object)
+    fmt = fixfmt.String(8)
+    tbl = _ext.Table()
+    tbl.add_str_object(arr, fmt, none="-")
+    for i, obj in enumerate(objs):
+        assert tbl(i) == fmt("-" if obj is None else str(obj))
+
+
+def test_object_cache():
+    import fixfmt
+    from fixfmt import _ext
+
+    words = np.array(["apple", "pear", "fig", 42, 2.5], dtype=object)
+    arr = words[np.arange(10000) % 5]
+    fmt = fixfmt.String(6)
+    tbl = _ext.Table()
+    tbl.add_str_object(arr, fmt)
+    expected = "\n".join(fmt(str(o)) for o in arr)
+    assert tbl.render_rows(0, 10000) == expected
+    assert tbl.object_cache_stats == (9995, 5)
+
+    # Distinct objects don't pay off, so the cache is dropped once full.
+    arr = np.array([str(i) for i in range(1000)], dtype=object)
+    tbl = _ext.Table()
+    tbl.add_str_object(arr, fmt, cache_size=100)
+    assert tbl.render_rows(0, 1000) == "\n".join(fmt(o) for o in arr)
+    assert tbl.object_cache_stats == (0, 101)
+
+    tbl = _ext.Table()
+    tbl.add_str_object(arr, fmt, cache_size=0)
+    assert tbl.render_rows(0, 1000) == "\n".join(fmt(o) for o in arr)
+    assert tbl.object_cache_stats == (0, 0)
+
+
+def test_cell_cache_stats():
+    import fixfmt
+    from fixfmt import _ext
+
+    length = 5000
+    tbl = _ext.Table()
+    tbl.add_float64(np.arange(length) % 10 / 4, fixfmt.Number(1, 2))
+    tbl.render_rows(0, length)
+    assert tbl.cell_cache_stats == (length, 0)
+
+
+def test_escapes():
+    import fixfmt
+    from fixfmt import _ext
+
+    # Escape sequences push cells past the byte bound; they're not truncated.
+    red = "\x1b[31mab\x1b[0m"
+    arr = np.array([red, "xy"] * 1000, dtype=object)
+    fmt = fixfmt.String(3)
+    for cache_size in (0, 16):
+        tbl = _ext.Table()
+        tbl.add_str_object(arr, fmt, cache_size=cache_size)
+        assert tbl(0) == fmt(red)
+        assert tbl.render_rows(0, 2000) == "\n".join(fmt(o) for o in arr)
+
+
+def test_runs():
+    import fixfmt
+    from fixfmt import _ext
+
+    tbl = _ext.Table()
+    tbl.add_runs(np.array([3, 3, 4, 4, 4]), fixfmt.Number(1), repeat="ditto")
+    tbl.add_string("|")
+    tbl.add_runs(
+        np.array([1.5, 2.0]), fixfmt.Number(1, 1),
+        run_lengths=np.array([2, 3]), repeat="blank")
+    tbl.add_string("|")
+    tbl.add_runs(np.array([True, True, False, True, True]), fixfmt.Bool())
+    assert tbl.render_rows(0, 5) == (
+        " 3| 1.5|true \n"
+        "\" |    |true \n"
+        " 4| 2.0|false\n"
+        "\" |    |true \n"
+        "\" |    |true "
+    )
+
+    with pytest.raises(TypeError):
+        tbl.add_runs(np.array([1, 2]), fixfmt.Bool())
+    with pytest.raises(ValueError):
+        tbl.add_runs(np.array([1, 2]), fixfmt.Number(1), repeat="twice")
+    with pytest.raises(ValueError):
+        tbl.add_runs(
+            np.array([1, 2]), fixfmt.Number(1), run_lengths=np.array([1]))
+    # Run lengths must be int64, and values in native byte order.
+    with pytest.raises(TypeError):
+        tbl.add_runs(
+            np.array([1, 2]), fixfmt.Number(1), run_lengths=np.array([1., 2.]))
+    with pytest.raises(TypeError):
+        tbl.add_runs(np.array([1, 2], dtype=">i4"), fixfmt.Number(1))
+    assert len(tbl) == 5
+
+    # A multibyte ditto, over several blocks.
+    arr = np.repeat(np.arange(1000), 3)
+    tbl = _ext.Table()
+    tbl.add_runs(arr, fixfmt.Number(3), repeat="ditto", ditto="\u3003")
+    fmt = fixfmt.Number(3)
+    assert tbl.render_rows(0, len(arr)) == "\n".join(
+        "  \u3003 " if i % 3 else fmt(v) for i, v in enumerate(arr))
+
+
+def test_visible_rows():
+    # A wide value and extra precision, both in the hidden rows.
+    arr = np.arange(10000, dtype=float)
+    arr[5000] = 1e9
+    arr[6000] = 0.5
+    strs = np.array(["x"] * 10000, dtype=object)
+    strs[7000] = "hidden"
+    mask = np.zeros(10000, dtype=bool)
+    mask[8000] = True
+
+    def fmt_lines(**formatters):
+        cfg = update_cfg(DEFAULT_CFG, {
+            "data": {"max_rows": 30},
+            "formatters": formatters,
+        })
+        tbl = Table(cfg)
+        tbl.add_column("x", arr)
+        tbl.add_column("s", strs)
+        tbl.add_column("m", arr, mask=mask)
+        tbl.finish()
+        return list(tbl.format())
+
+    lines = fmt_lines()
+    assert lines[2] == "         0.0 x               0.0"
+    assert lines[-1] == "      9999.0 x            9999.0"
+
+    lines = fmt_lines(rows="visible")
+    assert len(lines) == 30
+    assert lines[2] == "   0 x    0"
+    assert lines[-1] == "9999 x 9999"
+
+    # A sample of every row finds everything.
+    assert fmt_lines(rows="visible", sample_error=0) == fmt_lines()
+    lines = fmt_lines(rows="visible", sample_error=0.01)
+    assert lines[2].startswith("   0")
+
+    with pytest.raises(ValueError):
+        fmt_lines(rows="some")
@@ -1,5 +1,6 @@
 import numpy as np
 import fixfmt
+import fixfmt.npfmt
 
 NAT = np.datetime64("NAT")
 
@@ -54,3 +55,66 @@ def test_early():
     assert fmt(arr[4]) == "1970-01-01T00:00:00.000000+00:00"
 
 
+def test_duration():
+    fmt = fixfmt.TickDuration(scale=1000000000, precision=3)
+    assert fmt.width == 13
+    assert fmt(0) == " 00:00:00.000"
+    assert fmt(-1500000000) == "-00:00:01.500"
+    assert fmt(NAT.astype(int)) == "NaT          "
+
+    fmt = fixfmt.TickDuration(day_size=2, sign="+")
+    assert fmt(93784) == " +1d 02:03:04"
+
+
+def test_choose_duration():
+    arr = np.array([
+        np.timedelta64(1500, "ms"),
+        np.timedelta64("NaT"),
+        np.timedelta64(-3, "h"),
+    ], dtype="timedelta64[ms]")
+
+    fmt = fixfmt.npfmt.choose_formatter(arr)
+    assert isinstance(fmt, fixfmt.TickDuration)
+    assert fmt.precision == 1
+    assert fmt.day_size == 0
+
+    # Days widen to the min width, and are shown if necessary to reach it.
+    wide = fixfmt.npfmt.choose_formatter(arr, min_width=16)
+    assert (wide.width, wide.day_size) == (16, 3)
+    wide = fixfmt.npfmt.choose_formatter(arr, min_width=12)
+    assert (wide.width, wide.day_size) == (14, 1)
+    assert wide(1500) == " 0d 00:00:01.5"
+    arr = arr.astype(int)
+    assert fmt(arr[0]) == " 00:00:01.5"
+    assert fmt(arr[1]) == "NaT        "
+    assert fmt(arr[2]) == "-03:00:00.0"
+
+    arr = np.array([0, 86400 * 12], dtype="timedelta64[s]")
+    fmt = fixfmt.npfmt.choose_formatter(arr)
+    assert fmt.day_size == 2
+    assert fmt(arr.astype(int)[1]) == "12d 00:00:00"
+
+
+def test_choose_duration_rounded():
+    from fixfmt.npfmt import DEFAULT_CFG, choose_formatter_timedelta64
+
+    # Fields are sized for values as rounded.
+    cfg = dict(DEFAULT_CFG["duration"], max_precision=1)
+    arr = np.array([359999960], dtype="timedelta64[ms]")
+    fmt = choose_formatter_timedelta64(arr, cfg=cfg)
+    assert fmt.day_size == 1
+    assert fmt(arr.astype(int)[0]) == "4d 04:00:00.0"
+
+    arr = np.array([863999960], dtype="timedelta64[ms]")
+    fmt = choose_formatter_timedelta64(arr, cfg=cfg)
+    assert fmt.day_size == 2
+    assert fmt(arr.astype(int)[0]) == "10d 00:00:00.0"
+
+
+def test_duration_table():
+    from fixfmt.table import Table
+
+    tbl = Table()
+    tbl.add_column("dt", np.arange(5).astype("timedelta64[s]") * 60)
+    tbl.finish()
+    assert list(tbl.format())[5] == "00:03:00"
@@ -0,0 +1,408 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "fixfmt.hh"
+#include "gtest/gtest.h"
+
+using namespace fixfmt;
+using DTSC = double_conversion::DoubleToStringConverter;
+
+namespace {
+
+/*
+ * A plain scan in order, for comparison.
+ */
+template<typename TYPE>
+FloatAnalysis<TYPE>
+analyze_scalar(
+  std::vector<TYPE> const& values,
+  int const max_precision)
+{
+  FloatAnalysis<TYPE> result;
+  TYPE precision_scale = 1;
+  for (auto const val : values) {
+    if (std::isnan(val)) {
+      result.has_nan = true;
+      continue;
+    }
+    if (std::isinf(val)) {
+      if (val > 0)
+        result.has_pos_inf = true;
+      else
+        result.has_neg_inf = true;
+      continue;
+    }
+    ++result.num;
+    if (val < result.min)
+      result.min = val;
+    if (val > result.max)
+      result.max = val;
+
+    if (result.precision == max_precision)
+      continue;
+    double const scaled = val * precision_scale;
+    if (long(std::round(scaled)) == scaled)
+      continue;
+    char buf[384];
+    bool sign;
+    int length;
+    int decimal_pos;
+    DTSC::DoubleToAscii(
+      std::abs(val), analyze::FloatTraits<TYPE>::MODE, 0, buf, sizeof(buf),
+      &sign, &length, &decimal_pos);
+    auto const prec = std::min(length - decimal_pos, max_precision);
+    if (prec > result.precision) {
+      result.precision = prec;
+      precision_scale = pow10(prec);
+    }
+  }
+  return result;
+}
+
+
+template<typename TYPE>
+void
+expect_same(
+  std::vector<TYPE> const& values,
+  int const max_precision)
+{
+  auto const expected = analyze_scalar(values, max_precision);
+  for (int const num_threads : {1, 4}) {
+    auto const result = analyze_float(
+      values.data(), values.size(), sizeof(TYPE), max_precision, num_threads);
+    EXPECT_EQ(expected.has_nan, result.has_nan);
+    EXPECT_EQ(expected.has_pos_inf, result.has_pos_inf);
+    EXPECT_EQ(expected.has_neg_inf, result.has_neg_inf);
+    EXPECT_EQ(expected.num, result.num);
+    // Compare bits, to distinguish zeros.
+    EXPECT_EQ(0, memcmp(&expected.min, &result.min, sizeof(TYPE)));
+    EXPECT_EQ(0, memcmp(&expected.max, &result.max, sizeof(TYPE)));
+    EXPECT_EQ(expected.precision, result.precision);
+  }
+}
+
+
+}  // anonymous namespace
+
+TEST(analyze_float, basic) {
+  std::vector<double> const values{
+    1.5, -2.25, std::nan(""), 100, -INFINITY, 0.125};
+  auto const result = analyze_float(values.data(), values.size(), 8, 16);
+  EXPECT_TRUE(result.has_nan);
+  EXPECT_FALSE(result.has_pos_inf);
+  EXPECT_TRUE(result.has_neg_inf);
+  EXPECT_EQ(4, result.num);
+  EXPECT_EQ(-2.25, result.min);
+  EXPECT_EQ(100, result.max);
+  EXPECT_EQ(3, result.precision);
+
+  // Every other value.
+  auto const strided = analyze_float(values.data(), 3, 16, 16);
+  EXPECT_EQ(1, strided.num);
+  EXPECT_TRUE(strided.has_neg_inf);
+  EXPECT_EQ(1.5, strided.min);
+  EXPECT_EQ(1, strided.precision);
+
+  auto const empty = analyze_float<double>(nullptr, 0, 8, 16);
+  EXPECT_EQ(0, empty.num);
+  EXPECT_EQ(0, empty.precision);
+}
+
+TEST(analyze_float, same_as_scalar) {
+  std::mt19937_64 gen(42);
+  std::uniform_real_distribution<double> uniform(-1000, 1000);
+  long const n = 300000;
+
+  // Decimals with two fractional digits, many of which aren't exact when
+  // scaled.
+  std::vector<double> cents(n);
+  for (auto& v : cents)
+    v = std::round(uniform(gen) * 100) / 100;
+  expect_same(cents, 16);
+  expect_same(cents, 1);
+
+  // Full precision values.
+  std::vector<double> full(n);
+  for (auto& v : full)
+    v = uniform(gen);
+  expect_same(full, 16);
+  expect_same(full, 12);
+
+  // Integers, then more precision in a later chunk.
+  std::vector<double> ints(n);
+  for (auto& v : ints)
+    v = std::round(uniform(gen));
+  ints[200000] = 0.5;
+  ints[250000] = 0.001;
+  expect_same(ints, 16);
+
+  // Signed zeros, special values, and huge and tiny values.
+  std::vector<double> special(n, 0.0);
+  for (long i = 0; i < n; i += 7)
+    special[i] = -0.0;
+  special[5] = std::nan("");
+  special[70000] = INFINITY;
+  special[140000] = 1e300;
+  special[140001] = 1e-300;
+  special[140002] = std::numeric_limits<double>::denorm_min();
+  expect_same(special, 16);
+
+  std::vector<double> negative(n);
+  for (auto& v : negative)
+    v = -std::abs(uniform(gen)) - 1;
+  expect_same(negative, 16);
+}
+
+TEST(analyze_float, float) {
+  std::mt19937_64 gen(17);
+  std::uniform_real_distribution<float> uniform(-1000, 1000);
+  long const n = 200000;
+
+  std::vector<float> tenths(n);
+  for (auto& v : tenths)
+    v = std::round(uniform(gen) * 10) / 10;
+  expect_same(tenths, 8);
+
+  std::vector<float> full(n);
+  for (auto& v : full)
+    v = uniform(gen);
+  full[1000] = -0.0f;
+  full[1001] = 0.0f;
+  expect_same(full, 8);
+}
+
+TEST(analyze_float, scaled) {
+  std::mt19937_64 gen(5);
+  std::uniform_real_distribution<double> uniform(-1e6, 1e6);
+  long const n = 200000;
+
+  // Same as analyzing the values divided in advance.
+  std::vector<double> values(n);
+  for (auto& v : values)
+    v = std::round(uniform(gen));
+  auto divided = values;
+  for (auto& v : divided)
+    v /= 1000;
+  auto const expected = analyze_scalar(divided, 16);
+  for (int const num_threads : {1, 4}) {
+    auto const result = analyze_float(
+      values.data(), n, sizeof(double), 16, num_threads, 1000);
+    EXPECT_EQ(expected.num, result.num);
+    EXPECT_EQ(expected.min, result.min);
+    EXPECT_EQ(expected.max, result.max);
+    EXPECT_EQ(expected.precision, result.precision);
+  }
+
+  // Integers are analyzed as doubles.
+  std::vector<long> const ints{1500, -250, 12345, 7};
+  auto const result = analyze_float(ints.data(), 4, sizeof(long), 16, 0, 100);
+  static_assert(
+    std::is_same<decltype(result), FloatAnalysis<double> const>::value, "");
+  EXPECT_EQ(4, result.num);
+  EXPECT_EQ(-2.5, result.min);
+  EXPECT_EQ(123.45, result.max);
+  EXPECT_EQ(2, result.precision);
+
+  // Every other value.
+  auto const strided
+    = analyze_float(ints.data(), 2, 2 * sizeof(long), 16, 0, 10);
+  EXPECT_EQ(150, strided.min);
+  EXPECT_EQ(1234.5, strided.max);
+  EXPECT_EQ(1, strided.precision);
+}
+
+TEST(analyze_float, ranges) {
+  std::mt19937_64 gen(11);
+  std::uniform_real_distribution<double> uniform(-1000, 1000);
+  long const n = 300000;
+
+  std::vector<double> values(n);
+  for (auto& v : values)
+    v = std::round(uniform(gen) * 100) / 100;
+  values[150000] = 0.001;
+  std::vector<Range> const ranges{{0, 10}, {100000, 200000}, {299990, n}};
+
+  // Same as analyzing the rows in the ranges together.
+  std::vector<double> rows;
+  for (auto const& range : ranges)
+    rows.insert(
+      rows.end(), values.begin() + range.first, values.begin() + range.second);
+  auto const expected = analyze_scalar(rows, 16);
+  for (int const num_threads : {1, 4}) {
+    auto const result
+      = analyze_float(values.data(), sizeof(double), ranges, 16, num_threads);
+    EXPECT_EQ(expected.num, result.num);
+    EXPECT_EQ(expected.min, result.min);
+    EXPECT_EQ(expected.max, result.max);
+    EXPECT_EQ(3, result.precision);
+  }
+
+  auto const head
+    = analyze_float(values.data(), sizeof(double), {{0, 10}, {5, 5}}, 16);
+  EXPECT_EQ(10, head.num);
+  EXPECT_EQ(2, head.precision);
+
+  auto const none = analyze_float(
+    values.data(), sizeof(double), std::vector<Range>{}, 16);
+  EXPECT_EQ(0, none.num);
+}
+
+TEST(analyze_int, basic) {
+  std::vector<int> const values{12, -345, 6, 7890, 0};
+  auto const result = analyze_int(values.data(), values.size(), sizeof(int));
+  EXPECT_EQ(5, result.num);
+  EXPECT_EQ(-345, result.min);
+  EXPECT_EQ(7890, result.max);
+  EXPECT_EQ(4, result.digits);
+
+  // Every other value.
+  auto const strided = analyze_int(values.data(), 3, 2 * sizeof(int));
+  EXPECT_EQ(3, strided.num);
+  EXPECT_EQ(0, strided.min);
+  EXPECT_EQ(12, strided.max);
+  EXPECT_EQ(2, strided.digits);
+
+  auto const empty = analyze_int<short>(nullptr, 0, sizeof(short));
+  EXPECT_EQ(0, empty.num);
+  EXPECT_EQ(1, empty.digits);
+}
+
+TEST(analyze_int, limits) {
+  std::vector<long> const longs{0, std::numeric_limits<long>::min()};
+  auto const l = analyze_int(longs.data(), longs.size(), sizeof(long));
+  EXPECT_EQ(std::numeric_limits<long>::min(), l.min);
+  EXPECT_EQ(0, l.max);
+  EXPECT_EQ(19, l.digits);
+
+  std::vector<unsigned long> const ulongs{
+    3, std::numeric_limits<unsigned long>::max()};
+  auto const u = analyze_int(ulongs.data(), ulongs.size(), sizeof(long));
+  EXPECT_EQ(3u, u.min);
+  EXPECT_EQ(20, u.digits);
+
+  std::vector<signed char> const chars{-128, 0, 0};
+  auto const c = analyze_int(chars.data(), chars.size(), 1);
+  EXPECT_EQ(-128, c.min);
+  EXPECT_EQ(0, c.max);
+  EXPECT_EQ(3, c.digits);
+
+  std::vector<unsigned short> const zeros(1000, 0);
+  EXPECT_EQ(1, analyze_int(zeros.data(), zeros.size(), 2).digits);
+}
+
+TEST(analyze_int, ranges) {
+  std::vector<int> const values{12, -345, 6, 7890, 0};
+  auto const result
+    = analyze_int(values.data(), sizeof(int), {{0, 1}, {2, 3}, {4, 5}});
+  EXPECT_EQ(3, result.num);
+  EXPECT_EQ(0, result.min);
+  EXPECT_EQ(12, result.max);
+  EXPECT_EQ(2, result.digits);
+}
+
+TEST(analyze_strings, utf8) {
+  // Fixed-width strings, padded with NULs.
+  char const values[][8] = {"abc", "……", "", "\x1b[1mxyz", "1234567"};
+  EXPECT_EQ(7u, analyze_strings(values[0], 5, 8, 8, 64));
+  EXPECT_EQ(3u, analyze_strings(values[0], 4, 8, 8, 64));
+  EXPECT_EQ(2u, analyze_strings(values[0], 5, 8, 8, 2));
+  EXPECT_EQ(3u, analyze_strings(values[0], 2, 16, 8, 64));
+  EXPECT_EQ(0u, analyze_strings(values[2], 1, 8, 8, 64));
+  EXPECT_EQ(2u, analyze_strings(values[0], 8, {{1, 3}}, 8, 64));
+}
+
+TEST(analyze_strings, ucs4) {
+  char32_t const values[][5] = {U"ab", U"…", U"\U0001f600xyz"};
+  EXPECT_EQ(4u, analyze_strings(values[0], 3, 20, 5, 64));
+  EXPECT_EQ(2u, analyze_strings(values[0], 2, 20, 5, 64));
+  EXPECT_EQ(4u, analyze_strings(values[0], 2, 40, 5, 64));
+}
+
+TEST(analyze, unaligned) {
+  // Packed records of a double, an int, and four code points, starting at an
+  // odd address, so that no field is aligned.
+  long const stride = sizeof(double) + sizeof(int) + 4 * sizeof(char32_t);
+  std::vector<char> buf(1 + 3 * stride);
+  char32_t const strs[][4] = {U"ab", U"\U0001f600xy", U"c"};
+  double const dbls[] = {1.5, -2.25, 100};
+  int const ints[] = {7, -12345, 0};
+  for (long i = 0; i < 3; ++i) {
+    auto const rec = buf.data() + 1 + i * stride;
+    memcpy(rec, &dbls[i], sizeof(double));
+    memcpy(rec + sizeof(double), &ints[i], sizeof(int));
+    memcpy(rec + sizeof(double) + sizeof(int), strs[i], sizeof(strs[i]));
+  }
+  auto const base = buf.data() + 1;
+
+  auto const f = analyze_float(
+    reinterpret_cast<double const*>(base), 3, stride, 16);
+  EXPECT_EQ(3, f.num);
+  EXPECT_EQ(-2.25, f.min);
+  EXPECT_EQ(100, f.max);
+  EXPECT_EQ(2, f.precision);
+
+  auto const n = analyze_int(
+    reinterpret_cast<int const*>(base + sizeof(double)), 3, stride);
+  EXPECT_EQ(3, n.num);
+  EXPECT_EQ(-12345, n.min);
+  EXPECT_EQ(7, n.max);
+  EXPECT_EQ(5, n.digits);
+
+  EXPECT_EQ(3u, analyze_strings(
+    reinterpret_cast<char32_t const*>(base + sizeof(double) + sizeof(int)),
+    3, stride, 4, 64));
+}
+
+TEST(NumberStats, merge) {
+  std::vector<double> const values{1.5, -2.25, std::nan(""), 100, 0.125};
+  std::vector<int> const ints{12, -345, 6};
+
+  // Analyze in pieces and merge.
+  NumberStats stats;
+  analyze_number(stats, values.data(), sizeof(double), {{0, 2}}, 16);
+  NumberStats other;
+  analyze_number(other, values.data(), sizeof(double), {{2, 5}}, 16);
+  stats.merge(other);
+  EXPECT_TRUE(stats.has_nan);
+  EXPECT_FALSE(stats.has_pos_inf);
+  EXPECT_EQ(4, stats.num);
+  EXPECT_EQ(-2.25, stats.min);
+  EXPECT_EQ(100, stats.max);
+  EXPECT_EQ(3, stats.precision);
+  EXPECT_FALSE(stats.integer);
+
+  NumberStats int_stats;
+  analyze_number(int_stats, ints.data(), sizeof(int), {{0, 1}}, 16);
+  analyze_number(int_stats, ints.data(), sizeof(int), {{1, 3}}, 16);
+  EXPECT_TRUE(int_stats.integer);
+  EXPECT_EQ(3, int_stats.num);
+  EXPECT_EQ(-345, int_stats.min);
+  EXPECT_EQ(3, int_stats.digits);
+
+  // Scaled integers aren't integers.
+  NumberStats scaled;
+  analyze_number(scaled, ints.data(), sizeof(int), {{0, 3}}, 16, 0, 100);
+  EXPECT_FALSE(scaled.integer);
+  EXPECT_EQ(-3.45, scaled.min);
+  EXPECT_EQ(2, scaled.precision);
+
+  int_stats.merge(scaled);
+  EXPECT_FALSE(int_stats.integer);
+  EXPECT_EQ(6, int_stats.num);
+}
+
+TEST(StringStats, merge) {
+  StringStats stats;
+  stats.update(3, 5);
+  StringStats other;
+  other.update(2, 7);
+  stats.merge(other);
+  stats.merge(StringStats());
+  EXPECT_EQ(5, stats.num);
+  EXPECT_EQ(7u, stats.size);
+}
+
@@ -0,0 +1,178 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "fixfmt.hh"
+#include "gtest/gtest.h"
+
+using namespace fixfmt;
+
+namespace {
+
+// The structs are owned by the test, so there's nothing to release.
+void release_schema(ArrowSchema* const schema) { schema->release = nullptr; }
+void release_array(ArrowArray* const array) { array->release = nullptr; }
+
+ArrowSchema
+make_schema(
+  char const* const format,
+  ArrowSchema* const dictionary=nullptr)
+{
+  return {
+    format, nullptr, nullptr, ARROW_FLAG_NULLABLE, 0, nullptr, dictionary,
+    release_schema, nullptr};
+}
+
+ArrowArray
+make_array(
+  int64_t const length,
+  int64_t const null_count,
+  int64_t const offset,
+  int64_t const n_buffers,
+  void const** const buffers,
+  ArrowArray* const dictionary=nullptr)
+{
+  return {
+    length, null_count, offset, n_buffers, 0, buffers, nullptr, dictionary,
+    release_array, nullptr};
+}
+
+std::string
+render(
+  Table const& table)
+{
+  std::string buf;
+  table.render_rows(0, table.get_length(), buf);
+  return buf;
+}
+
+}  // anonymous namespace
+
+TEST(arrow, primitive) {
+  // Skip the first value; the third is null.
+  uint8_t const valid[] = {0b11111011};
+  int32_t const values[] = {1, 2, 3, 4, 5};
+  void const* buffers[] = {valid, values};
+  auto const schema = make_schema("i");
+  auto const array = make_array(4, 1, 1, 2, buffers);
+
+  Table table;
+  table.add_string("[");
+  add_arrow_column(table, schema, array, Number(3), "-");
+  table.add_string("]");
+  ASSERT_EQ(4, table.get_length());
+  ASSERT_EQ("[   2]\n[-   ]\n[   4]\n[   5]", render(table));
+
+  // No nulls; the validity buffer may be absent.
+  double const doubles[] = {0.5, -1.25};
+  void const* dbl_buffers[] = {nullptr, doubles};
+  Table dbl_table;
+  add_arrow_column(
+    dbl_table, make_schema("g"), make_array(2, 0, 0, 2, dbl_buffers),
+    Number(2, 2));
+  ASSERT_EQ("  0.50\n -1.25", render(dbl_table));
+}
+
+TEST(arrow, bool) {
+  uint8_t const valid[] = {0b11110111};
+  uint8_t const values[] = {0b10100101};
+  void const* buffers[] = {valid, values};
+
+  Table table;
+  add_arrow_column(
+    table, make_schema("b"), make_array(5, 1, 2, 2, buffers),
+    Bool("yes", "no"), "?");
+  ASSERT_EQ("yes\n?  \nno \nyes\nno ", render(table));
+}
+
+TEST(arrow, utf8) {
+  int32_t const offsets[] = {0, 1, 3, 3, 8};
+  char const data[] = "abcdéfg";
+  void const* buffers[] = {nullptr, offsets, data};
+
+  Table table;
+  add_arrow_column(
+    table, make_schema("u"), make_array(3, 0, 1, 3, buffers), String(4));
+  ASSERT_EQ("bc  \n    \ndéfg", render(table));
+
+  int64_t const large_offsets[] = {0, 1, 3, 3, 8};
+  buffers[1] = large_offsets;
+  Table large;
+  add_arrow_column(
+    large, make_schema("U"), make_array(4, 0, 0, 3, buffers), String(5));
+  ASSERT_EQ("a    \nbc   \n     \ndéfg ", render(large));
+}
+
+TEST(arrow, dictionary) {
+  int32_t const offsets[] = {0, 3, 6};
+  char const data[] = "redblu";
+  void const* dict_buffers[] = {nullptr, offsets, data};
+  auto dict_schema = make_schema("u");
+  auto dict_array = make_array(2, 0, 0, 3, dict_buffers);
+
+  uint8_t const valid[] = {0b1011};
+  int8_t const indices[] = {1, 0, 1, 1};
+  void const* buffers[] = {valid, indices};
+  auto const schema = make_schema("c", &dict_schema);
+  auto const array = make_array(4, 1, 0, 2, buffers, &dict_array);
+
+  Table table;
+  add_arrow_column(table, schema, array, String(4), "n/a");
+  ASSERT_EQ("blu \nred \nn/a \nblu ", render(table));
+}
+
+TEST(arrow, timestamp) {
+  int64_t const values[] = {0, 1500000, TickTime::NAT_VALUE};
+  void const* buffers[] = {nullptr, values};
+
+  Table table;
+  add_arrow_column(
+    table, make_schema("tsu:UTC"), make_array(2, 0, 0, 2, buffers),
+    TickTime(TickTime::SCALE_USEC, 1));
+  ASSERT_EQ(
+    "1970-01-01T00:00:00.0+00:00\n1970-01-01T00:00:01.5+00:00", render(table));
+
+  Table durations;
+  add_arrow_column(
+    durations, make_schema("tDs"), make_array(1, 0, 0, 2, buffers),
+    TickDuration(TickTime::SCALE_SEC));
+  ASSERT_EQ(" 00:00:00", render(durations));
+}
+
+TEST(arrow, errors) {
+  int32_t const values[] = {1, 2};
+  void const* buffers[] = {nullptr, values};
+  auto const array = make_array(2, 0, 0, 2, buffers);
+  Table table;
+
+  // The wrong formatter for the type.
+  ASSERT_THROW(
+    add_arrow_column(table, make_schema("i"), array, String(4)),
+    std::invalid_argument);
+  // Unsupported types.
+  ASSERT_THROW(
+    add_arrow_column(table, make_schema("e"), array, Number(3)),
+    std::invalid_argument);
+  ASSERT_THROW(
+    add_arrow_column(table, make_schema("+l"), array, Number(3)),
+    std::invalid_argument);
+  // The wrong unit.
+  ASSERT_THROW(
+    add_arrow_column(
+      table, make_schema("tsm:"), array, TickTime(TickTime::SCALE_SEC)),
+    std::invalid_argument);
+  // A missing buffer.
+  ASSERT_THROW(
+    add_arrow_column(
+      table, make_schema("i"), make_array(2, 0, 0, 1, buffers), Number(3)),
+    std::invalid_argument);
+  // A released array.
+  auto released = make_schema("i");
+  released.release = nullptr;
+  ASSERT_THROW(
+    add_arrow_column(table, released, array, Number(3)),
+    std::invalid_argument);
+
+  ASSERT_EQ(0, table.get_width());
+}
+
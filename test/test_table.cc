@@ -0,0 +1,624 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "fixfmt.hh"
+#include "gtest/gtest.h"
+
+using namespace fixfmt;
+
+namespace {
+
+long const INTS[]       = {0, 42, -7, 12345};
+double const DOUBLES[]  = {1.5, NAN, -0.25, INFINITY};
+bool const BOOLS[]      = {true, false, false, true};
+
+// A number formatter with its own NaN and infinity strings.
+Number
+make_number(
+  int const size,
+  int const precision,
+  std::string const& nan,
+  std::string const& inf)
+{
+  Number::Args args;
+  args.size = size;
+  args.precision = precision;
+  args.nan = nan;
+  args.inf = inf;
+  return Number(args);
+}
+
+Table
+make_table()
+{
+  Table table;
+  table.add_string("| ");
+  table.add_column(std::make_unique<ColumnImpl<long, Number>>(
+    INTS, 4, Number(5)));
+  table.add_string(" | ");
+  table.add_column(std::make_unique<ColumnImpl<double, Number>>(
+    DOUBLES, 4, make_number(2, 2, "NaN", "∞")));
+  table.add_string(" | ");
+  table.add_column(std::make_unique<ColumnImpl<bool, Bool>>(
+    BOOLS, 4, Bool("yes", "no")));
+  table.add_string(" |");
+  return table;
+}
+
+}  // anonymous namespace
+
+TEST(Table, row) {
+  auto const table = make_table();
+  ASSERT_EQ(4, table.get_length());
+  ASSERT_EQ(25, table.get_width());
+  ASSERT_EQ("|      0 |   1.50 | yes |", table(0));
+  ASSERT_EQ("|     42 | NaN    | no  |", table(1));
+  ASSERT_EQ("|     -7 |  -0.25 | no  |", table(2));
+  ASSERT_EQ("|  12345 |   ∞    | yes |", table(3));
+}
+
+TEST(Table, render_row) {
+  auto const table = make_table();
+  for (long i = 0; i < table.get_length(); ++i) {
+    std::string buf = "> ";
+    table.render_row(i, buf);
+    ASSERT_LE(buf.size(), 2 + table.get_max_bytes());
+    ASSERT_EQ("> " + table(i), buf);
+  }
+}
+
+TEST(Table, overlong_cells) {
+  // Escape sequences push cells past the byte bound; they're never truncated.
+  long const length = Table::BLOCK_SIZE + 3;
+  std::vector<std::string> words(length);
+  for (long i = 0; i < length; ++i)
+    words[i] = i % 100 == 7 ? "\x1b[31mabc\x1b[0m" : "xyz";
+  std::string utf8s(length * 16, '\0');
+  for (long i = 0; i < length; ++i)
+    memcpy(&utf8s[i * 16], words[i].data(), words[i].size());
+
+  Table table;
+  table.add_string("[");
+  table.add_column(std::make_unique<ColumnImpl<std::string, String>>(
+    words.data(), length, String(3)));
+  table.add_string("|");
+  table.add_utf8(utf8s.data(), 16, length, String(3));
+  table.add_string("]");
+
+  std::string const red = "\x1b[31mabc\x1b[0m";
+  ASSERT_EQ("[" + red + "|" + red + "]", table(7));
+  ASSERT_EQ("[xyz|xyz]", table(8));
+
+  std::string row = "> ";
+  table.render_row(7, row);
+  ASSERT_EQ("> " + table(7), row);
+  std::string cell(table.get_max_bytes(), '\0');
+  ASSERT_EQ(table(7).size(), table.format(7, &cell[0]) - &cell[0]);
+
+  std::string expected;
+  for (long i = 0; i < length; ++i)
+    expected += (i == 0 ? "" : "\n") + table(i);
+  std::string buf;
+  table.render_rows(0, length, buf);
+  ASSERT_EQ(expected, buf);
+  buf.clear();
+  table.render_parallel(0, length, buf, 2);
+  ASSERT_EQ(expected, buf);
+
+  std::vector<size_t> ends;
+  buf.clear();
+  table.render_rows(0, length, buf, &ends);
+  ASSERT_EQ(length, (long) ends.size());
+  ASSERT_EQ(table(7), buf.substr(ends[6] + 1, ends[7] - ends[6] - 1));
+  ASSERT_EQ(table(length - 1), buf.substr(ends[length - 2] + 1));
+
+  // Categories with escape sequences are laid out at their full size.
+  std::vector<int> codes = {0, 1, -1, 1};
+  IndexedColumn<int> indexed(
+    codes.data(), 4, ColumnImpl<std::string, String>(&words[6], 2, String(3)));
+  ASSERT_EQ(red, indexed(1));
+  ASSERT_EQ("   ", indexed(2));
+  ASSERT_EQ(red.size(), indexed.get_max_bytes());
+}
+
+TEST(Table, render_rows) {
+  auto const table = make_table();
+  std::string buf = "> ";
+  table.render_rows(1, 3, buf);
+  ASSERT_EQ("> " + table(1) + "\n" + table(2), buf);
+
+  // An empty range renders nothing.
+  table.render_rows(2, 2, buf);
+  ASSERT_EQ("> " + table(1) + "\n" + table(2), buf);
+
+  // The end of each row, where its newline is or would be.
+  std::string rows = "> ";
+  std::vector<size_t> ends;
+  table.render_rows(0, 3, rows, &ends);
+  ASSERT_EQ(3u, ends.size());
+  ASSERT_EQ(2 + table(0).size(), ends[0]);
+  ASSERT_EQ(table(1), rows.substr(ends[0] + 1, ends[1] - ends[0] - 1));
+  ASSERT_EQ(rows.size(), ends[2]);
+}
+
+TEST(Table, render_rows_fixed_bytes) {
+  // More rows than a block.
+  long const length = 2 * Table::BLOCK_SIZE + 17;
+  std::vector<long> ints(length);
+  std::vector<double> doubles(length);
+  std::unique_ptr<bool[]> bools(new bool[length]);
+  for (long i = 0; i < length; ++i) {
+    ints[i] = i * 37 - 1000;
+    doubles[i] = i % 5 == 0 ? NAN : i / 16.0;
+    bools[i] = i % 3 == 0;
+  }
+
+  Table table;
+  table.add_column(std::make_unique<ColumnImpl<long, Number>>(
+    ints.data(), length, Number(6)));
+  table.add_string(" ");
+  table.add_column(std::make_unique<ColumnImpl<double, Number>>(
+    doubles.data(), length, Number(4, 4)));
+  table.add_string(" │ ");
+  table.add_column(std::make_unique<ColumnImpl<bool, Bool>>(
+    bools.get(), length, Bool()));
+  ASSERT_TRUE(table.is_fixed_bytes());
+
+  std::string expected;
+  for (long i = 3; i < length; ++i)
+    expected += (i > 3 ? "\n" : "") + table(i);
+  std::string buf;
+  table.render_rows(3, length, buf);
+  ASSERT_EQ(expected, buf);
+
+  // Not fixed bytes, since the NaN string is multibyte.
+  Table other;
+  other.add_column(std::make_unique<ColumnImpl<double, Number>>(
+    doubles.data(), length, 
+    make_number(4, 4, "∅", "inf")));
+  ASSERT_FALSE(other.is_fixed_bytes());
+  buf.clear();
+  other.render_rows(0, 11, buf);
+  ASSERT_EQ(10, std::count(buf.begin(), buf.end(), '\n'));
+  ASSERT_EQ(other(10), buf.substr(buf.rfind('\n') + 1));
+}
+
+TEST(Table, render_parallel) {
+  long const length = 10 * Table::BLOCK_SIZE + 123;
+  std::vector<long> ints(length);
+  std::vector<double> doubles(length);
+  for (long i = 0; i < length; ++i) {
+    ints[i] = i * 7919 % 100003;
+    doubles[i] = i % 7 == 0 ? NAN : i / 3.0;
+  }
+
+  for (auto const nan : {"NaN", "∅"}) {
+    Table table;
+    table.add_column(std::make_unique<ColumnImpl<long, Number>>(
+      ints.data(), length, Number(6)));
+    table.add_string(" ");
+    table.add_column(std::make_unique<ColumnImpl<double, Number>>(
+      doubles.data(), length, make_number(5, 3, nan, "inf")));
+
+    std::string expected;
+    table.render_rows(5, length, expected);
+    for (int const num_threads : {1, 2, 3, 8}) {
+      std::string buf;
+      table.render_parallel(5, length, buf, num_threads);
+      ASSERT_EQ(expected, buf);
+    }
+  }
+}
+
+TEST(run_parallel, uneven) {
+  // Tasks of very uneven cost, all run exactly once.
+  long const num_tasks = 1000;
+  std::vector<int> counts(num_tasks, 0);
+  run_parallel(num_tasks, 4, [&](long const task) {
+    if (task < 10)
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ++counts[task];
+  });
+  ASSERT_EQ(num_tasks, std::count(counts.begin(), counts.end(), 1));
+}
+
+TEST(run_parallel, throws) {
+  // A task's exception reaches the caller, after all threads have stopped.
+  long const num_tasks = 1000;
+  std::atomic<long> num_run{0};
+  ASSERT_THROW(
+    run_parallel(num_tasks, 4, [&](long const task) {
+      ++num_run;
+      if (task == 300)
+        throw std::runtime_error("task failed");
+    }),
+    std::runtime_error);
+  ASSERT_LT(num_run, num_tasks);
+}
+
+TEST(Table, kinds) {
+  long const length = Table::BLOCK_SIZE + 77;
+  std::vector<signed char> int8s(length);
+  std::vector<unsigned short> uint16s(length);
+  std::vector<int> int32s(length);
+  std::vector<float> floats(length);
+  std::unique_ptr<bool[]> bools(new bool[length]);
+  std::vector<long> ticks(length);
+  std::vector<char> utf8s(length * 4, 0);
+  std::vector<char32_t> ucs4s(length * 2, 0);
+  char const* const words[] = {"a", "bc", "déf", "ghij"};
+  for (long i = 0; i < length; ++i) {
+    int8s[i] = i % 256 - 128;
+    uint16s[i] = i * 31;
+    int32s[i] = -i * 1001;
+    floats[i] = i % 11 == 0 ? NAN : i / 4.0f;
+    bools[i] = i % 2 == 0;
+    ticks[i] = i % 13 == 0 ? TickTime::NAT_VALUE : i * 86413;
+    strncpy(&utf8s[i * 4], words[i % 4], 4);
+    ucs4s[i * 2] = U'α' + i % 20;
+    if (i % 3 == 0)
+      ucs4s[i * 2 + 1] = U'z';
+  }
+  Number const number(7, 2);
+  TickDuration const duration(TickTime::SCALE_SEC, -1, 4);
+
+  // The same columns, formatted directly and through the virtual interface.
+  Table table;
+  table.add_string("[");
+  table.add_column(int8s.data(), length, Number(4));
+  table.add_string(" ");
+  table.add_string("|");
+  table.add_column(uint16s.data(), length, Number(6));
+  table.add_column(int32s.data(), length, Number(8));
+  table.add_column(floats.data(), length, number);
+  table.add_column(bools.get(), length, Bool("yes", "no"));
+  table.add_column(ticks.data(), length, duration);
+  table.add_utf8(utf8s.data(), 4, length, String(3));
+  table.add_ucs32((char const*) ucs4s.data(), 8, length, String(3));
+  table.add_string("]");
+
+  Table virt;
+  virt.add_string("[");
+  virt.add_column(std::make_unique<ColumnImpl<signed char, Number>>(
+    int8s.data(), length, Number(4)));
+  virt.add_string(" |");
+  virt.add_column(std::make_unique<ColumnImpl<unsigned short, Number>>(
+    uint16s.data(), length, Number(6)));
+  virt.add_column(std::make_unique<ColumnImpl<int, Number>>(
+    int32s.data(), length, Number(8)));
+  virt.add_column(std::make_unique<ColumnImpl<float, Number>>(
+    floats.data(), length, number));
+  virt.add_column(std::make_unique<ColumnImpl<bool, Bool>>(
+    bools.get(), length, Bool("yes", "no")));
+  virt.add_column(std::make_unique<ColumnImpl<long, TickDuration>>(
+    ticks.data(), length, duration));
+
+  ASSERT_EQ(length, table.get_length());
+  ASSERT_FALSE(table.is_fixed_bytes());
+  ASSERT_EQ(
+    "[  -61 |   2077   -67067      16.75no    67d 00:14:31gh…θ  ]", table(67));
+  ASSERT_EQ(
+    "[ -128 |      0        0     NaN   yesNaT            a  αz ]", table(0));
+  ASSERT_EQ(
+    "[ -125 |     93    -3003       0.75no     3d 00:00:39gh…δz ]", table(3));
+
+  std::string buf;
+  table.render_rows(0, length, buf);
+  std::string virt_buf;
+  for (long i = 0; i < length; ++i) {
+    auto const row = table(i);
+    auto const virt_row = virt(i);
+    ASSERT_EQ(virt_row, row.substr(0, virt_row.size()));
+    virt_buf += row + (i < length - 1 ? "\n" : "");
+  }
+  ASSERT_EQ(virt_buf, buf);
+
+  std::string parallel_buf;
+  table.render_parallel(0, length, parallel_buf, 3);
+  ASSERT_EQ(buf, parallel_buf);
+}
+
+TEST(Table, long_long) {
+  // 'long long' and 'long' columns format alike.
+  long long const lls[] = {-12345678901234ll, 0, 42};
+  unsigned long long const ulls[] = {1234567890123456789ull, 7, 0};
+  Table table;
+  table.add_column(lls, 3, Number(14));
+  table.add_string(" ");
+  table.add_column(ulls, 3, Number(19));
+  ASSERT_EQ("-12345678901234  1234567890123456789", table(0));
+  ASSERT_EQ("             42                    0", table(2));
+}
+
+TEST(IndexedColumn, basic) {
+  double const categories[] = {1.5, NAN, -20.25};
+  int const codes[] = {0, 2, -1, 1, 2, 0, 3};
+  IndexedColumn<int> const col(
+    codes, 7, ColumnImpl<double, Number>(categories, 3, Number(3, 2)));
+  ASSERT_EQ(7, col.get_length());
+  ASSERT_EQ(7, col.get_width());
+  ASSERT_TRUE(col.is_fixed_bytes());
+  ASSERT_EQ("   1.50", col(0));
+  ASSERT_EQ(" -20.25", col(1));
+  // Missing codes, and codes out of range.
+  ASSERT_EQ("       ", col(2));
+  ASSERT_EQ(" NaN   ", col(3));
+  ASSERT_EQ("       ", col(6));
+
+  // A missing string, and a multibyte category.
+  char const* const strings[] = {"x", "∞"};
+  std::vector<std::string> words(strings, strings + 2);
+  long const str_codes[] = {1, -1, 0};
+  IndexedColumn<long> const str_col(
+    str_codes, 3,
+    ColumnImpl<std::string, String>(words.data(), 2, String(3)), "-");
+  ASSERT_FALSE(str_col.is_fixed_bytes());
+  ASSERT_EQ("∞  ", str_col(0));
+  ASSERT_EQ("-  ", str_col(1));
+
+  Table table;
+  table.add_string("|");
+  table.add_column(std::make_unique<IndexedColumn<int>>(col));
+  table.add_string("|");
+  std::string buf;
+  table.render_rows(0, 7, buf);
+  ASSERT_EQ(
+    "|   1.50|\n| -20.25|\n|       |\n| NaN   |\n| -20.25|\n|   1.50|\n|       |",
+    buf);
+}
+
+TEST(Table, strided) {
+  // A column of a row-major matrix, and a field of an array of structs.
+  long const mat[3][2] = {{1, 10}, {2, 20}, {3, 30}};
+  struct Rec { char name[4]; double val; } const recs[] = {
+    {"ab", 0.5}, {"cde", -1.25}, {"f", 2}};
+
+  Table table;
+  table.add_column(&mat[0][1], 3, Number(3), sizeof(mat[0]));
+  table.add_string(" ");
+  table.add_utf8(recs[0].name, 4, sizeof(Rec), 3, String(3));
+  table.add_column(std::make_unique<ColumnImpl<double, Number>>(
+    &recs[0].val, 3, Number(2, 2), sizeof(Rec)));
+  ASSERT_EQ("  10 ab   0.50", table(0));
+  ASSERT_EQ("  20 cde -1.25", table(1));
+  ASSERT_EQ("  30 f    2.00", table(2));
+}
+
+TEST(Table, unaligned) {
+  // Packed records of an int and a double, starting at an odd address.
+  long const length = 3;
+  int const ints[] = {7, -300, 12};
+  double const doubles[] = {0.5, -1.25, 8};
+  size_t const stride = sizeof(int) + sizeof(double);
+  std::vector<char> buf(1 + length * stride);
+  char* const recs = &buf[1];
+  for (long i = 0; i < length; ++i) {
+    memcpy(recs + i * stride, &ints[i], sizeof(int));
+    memcpy(recs + i * stride + sizeof(int), &doubles[i], sizeof(double));
+  }
+
+  Table table;
+  table.add_column((int const*) recs, length, Number(3), stride);
+  table.add_string(" ");
+  table.add_column(std::make_unique<ColumnImpl<double, Number>>(
+    (double const*) (recs + sizeof(int)), length, Number(1, 2), stride));
+  ASSERT_EQ("   7  0.50", table(0));
+  ASSERT_EQ("-300 -1.25", table(1));
+  std::string rows;
+  table.render_rows(0, length, rows);
+  ASSERT_EQ("   7  0.50\n-300 -1.25\n  12  8.00", rows);
+}
+
+TEST(Table, valid) {
+  // Runs of valid and null entries, and mixed words, at an unaligned offset.
+  long const length = 300;
+  long const offset = 5;
+  std::vector<uint8_t> valid((offset + length + 7) / 8, 0);
+  std::vector<long> ints(length);
+  std::vector<std::string> words(length);
+  for (long i = 0; i < length; ++i) {
+    ints[i] = i * 11;
+    words[i] = std::string(i % 4, 'x');
+    if (i < 100 || (200 <= i && i % 3 != 0))
+      valid[(offset + i) / 8] |= 1 << ((offset + i) % 8);
+  }
+
+  Table table;
+  table.add_column(ints.data(), length, Number(4));
+  table.set_valid(valid.data(), offset, "-");
+  table.add_string("|");
+  table.add_column(std::make_unique<ColumnImpl<std::string, String>>(
+    words.data(), length, String(3)));
+  table.set_valid(valid.data(), offset, "∅");
+  ASSERT_FALSE(table.is_fixed_bytes());
+  ASSERT_EQ(9, table.get_width());
+
+  std::string expected;
+  for (long i = 0; i < length; ++i) {
+    bool const v = i < 100 || (200 <= i && i % 3 != 0);
+    auto const row =
+      v ? Number(4)(ints[i]) + "|" + String(3)(words[i]) : "-    |∅  ";
+    ASSERT_EQ(row, table(i));
+    expected += (i > 0 ? "\n" : "") + row;
+  }
+  std::string buf;
+  table.render_rows(0, length, buf);
+  ASSERT_EQ(expected, buf);
+
+  // Fixed bytes, starting mid-word.
+  Table fixed;
+  fixed.add_column(ints.data(), length, Number(4));
+  fixed.set_valid(valid.data(), offset, "n/a");
+  ASSERT_TRUE(fixed.is_fixed_bytes());
+  std::string fixed_expected;
+  for (long i = 37; i < length; ++i)
+    fixed_expected += (i > 37 ? "\n" : "") + fixed(i);
+  ASSERT_EQ("n/a  ", fixed(150));
+  buf.clear();
+  fixed.render_rows(37, length, buf);
+  ASSERT_EQ(fixed_expected, buf);
+}
+
+TEST(Table, bool_bits) {
+  // Bit-packed and byte bools, at an unaligned offset, across several words.
+  long const length = 2 * Table::BLOCK_SIZE + 45;
+  long const offset = 13;
+  std::vector<uint8_t> bits((offset + length + 7) / 8, 0);
+  std::unique_ptr<bool[]> bools(new bool[length]);
+  for (long i = 0; i < length; ++i) {
+    bools[i] = (i * 7919) % 5 < 2 || (500 <= i && i < 700);
+    if (bools[i])
+      bits[(offset + i) / 8] |= 1 << ((offset + i) % 8);
+  }
+
+  for (auto const& fmt : {Bool("yes", "no"), Bool("✔", "no")}) {
+    Table table;
+    table.add_bool_bits(bits.data(), offset, length, fmt);
+    table.add_string("|");
+    table.add_column(bools.get(), length, fmt);
+    ASSERT_EQ(fmt.is_fixed_bytes(), table.is_fixed_bytes());
+
+    std::string buf;
+    table.render_rows(7, length, buf);
+    std::string expected;
+    for (long i = 7; i < length; ++i) {
+      auto const str = fmt(bools[i]);
+      ASSERT_EQ(str + "|" + str, table(i));
+      expected += (i > 7 ? "\n" : "") + table(i);
+    }
+    ASSERT_EQ(expected, buf);
+  }
+}
+
+TEST(Table, cell_cache) {
+  long const length = 10 * Table::BLOCK_SIZE + 3;
+  double const specials[] = {0.0, -0.0, NAN, -NAN, std::nan("7"), INFINITY};
+  std::vector<double> low(length);
+  std::vector<double> drift(length);
+  std::vector<int> high(length);
+  for (long i = 0; i < length; ++i) {
+    low[i] = i % 7 < 6 ? specials[i % 7] : (i % 50) / 4.0;
+    // Low cardinality in the first blocks only.
+    drift[i] = i < 2 * Table::BLOCK_SIZE ? i % 10 : i * 0.125;
+    high[i] = i * 7919;
+  }
+  Number const fmt = make_number(3, 2, "NaN", "∞");
+
+  Table table;
+  table.add_column(low.data(), length, fmt);
+  table.add_string("|");
+  table.add_column(drift.data(), length, fmt);
+  table.add_string("|");
+  table.add_column(high.data(), length, Number(9));
+  // The first two columns have caches.
+  ASSERT_EQ(2, table.get_cell_cache_stats().num_caches);
+
+  // The same columns, formatted without caches.
+  Table direct;
+  direct.add_column(std::make_unique<ColumnImpl<double, Number>>(
+    low.data(), length, fmt));
+  direct.add_string("|");
+  direct.add_column(std::make_unique<ColumnImpl<double, Number>>(
+    drift.data(), length, fmt));
+  direct.add_string("|");
+  direct.add_column(std::make_unique<ColumnImpl<int, Number>>(
+    high.data(), length, Number(9)));
+
+  std::string expected;
+  direct.render_rows(0, length, expected);
+  std::string buf;
+  table.render_rows(0, length, buf);
+  ASSERT_EQ(expected, buf);
+  buf.clear();
+  table.render_parallel(0, length, buf, 4);
+  ASSERT_EQ(expected, buf);
+
+  // Once the drifting column's values fill its cache, it's turned off.
+  ASSERT_EQ(1, table.get_cell_cache_stats().num_enabled);
+
+  // The low cardinality column's cache holds all its values.
+  Table low_table;
+  low_table.add_column(low.data(), length, fmt);
+  buf.clear();
+  low_table.render_rows(0, length, buf);
+  low_table.render_parallel(0, length, buf, 4);
+  auto const stats = low_table.get_cell_cache_stats();
+  ASSERT_EQ(1, stats.num_enabled);
+  ASSERT_EQ(0, stats.misses);
+  ASSERT_EQ(2 * length, stats.hits);
+}
+
+TEST(RunColumn, plain) {
+  double const vals[] = {1.5, 1.5, 1.5, -0.0, 0.0, 0.0, NAN, NAN, 2};
+  Number const fmt(2, 1);
+  using Col = RunColumn<double, Number>;
+
+  Col const show(vals, 9, fmt);
+  Col const blank(vals, 9, fmt, Col::REPEAT_BLANK);
+  Col const ditto(vals, 9, fmt, Col::REPEAT_DITTO, "〃");
+  ASSERT_TRUE(show.is_fixed_bytes());
+  ASSERT_TRUE(blank.is_fixed_bytes());
+  ASSERT_FALSE(ditto.is_fixed_bytes());
+  ASSERT_EQ("  1.5", show(2));
+  ASSERT_EQ("     ", blank(2));
+  ASSERT_EQ("  〃  ", ditto(2));
+  // -0.0 and 0.0 aren't bitwise equal, so aren't a run; NaNs are.
+  ASSERT_EQ("  0.0", ditto(3));
+  ASSERT_EQ("  0.0", ditto(4));
+  ASSERT_EQ("  〃  ", ditto(5));
+  ASSERT_EQ("NaN  ", ditto(6));
+  ASSERT_EQ("  〃  ", ditto(7));
+
+  // Formatting a block notes each entry's size.
+  std::string block(9 * 8, '\0');
+  size_t sizes[9];
+  ditto.format_block(0, 9, &block[0], 8, sizes);
+  for (long i = 0; i < 9; ++i)
+    ASSERT_EQ(ditto(i), block.substr(i * 8, sizes[i]));
+
+  for (auto const* col : {&show, &blank, &ditto}) {
+    // Blocks starting at each row, including mid-run.
+    for (long begin = 0; begin < 9; ++begin) {
+      Table table;
+      table.add_string("|");
+      table.add_column(std::make_unique<Col>(*col));
+      std::string buf;
+      table.render_rows(begin, 9, buf);
+      std::string expected;
+      for (long i = begin; i < 9; ++i)
+        expected += (i > begin ? "\n|" : "|") + (*col)(i);
+      ASSERT_EQ(expected, buf);
+    }
+  }
+}
+
+TEST(RunColumn, rle) {
+  long const vals[] = {10, 20, 30, 20, 40};
+  long const lengths[] = {3, 1, 0, 2, 1500};
+  using Col = RunColumn<long, Number>;
+  Col const col(vals, lengths, 5, Number(3), Col::REPEAT_DITTO);
+  ASSERT_EQ(1506, col.get_length());
+
+  char const* const expected[] = {
+    "  10", "  \" ", "  \" ", "  20", "  20", "  \" ", "  40", "  \" "};
+  for (long i = 0; i < 8; ++i)
+    ASSERT_EQ(expected[i], col(i));
+  ASSERT_EQ("  \" ", col(1505));
+
+  Table table;
+  table.add_column(std::make_unique<Col>(col));
+  std::string buf;
+  table.render_rows(1, 8, buf);
+  ASSERT_EQ("  \" \n  \" \n  20\n  20\n  \" \n  40\n  \" ", buf);
+  buf.clear();
+  table.render_rows(0, 1506, buf);
+  ASSERT_EQ(1502, std::count(buf.begin(), buf.end(), '"'));
+}
+
@@ -27,6 +27,24 @@ TEST(string_length, basic) {
   ASSERT_EQ(string_length(" \x1b[32m\u2502\x1b[m "), 3u);
 }
 
+TEST(string_length, range) {
+  std::string const str = "\x1b[32m\u2502x";
+  ASSERT_EQ(string_length(str.begin(), str.end()), 2u);
+  char const* const chars = str.c_str();
+  ASSERT_EQ(string_length(chars, chars + str.length()), 2u);
+  ASSERT_EQ(string_length(chars, chars + str.length() - 2), 1u);
+  ASSERT_EQ(string_length(chars, chars), 0u);
+}
+
+TEST(code_point_length, basic) {
+  std::u32string const str = U"\x1b[32m\u2502\U0001f600 x\x1b[m";
+  ASSERT_EQ(code_point_length(str.data(), str.data() + str.length()), 4u);
+  ASSERT_EQ(code_point_length(str.data(), str.data() + 2), 0u);
+  // A code point that truncates to a final byte doesn't end a sequence.
+  std::u32string const wide = U"\x1b[\u0140x";
+  ASSERT_EQ(code_point_length(wide.data(), wide.data() + wide.length()), 0u);
+}
+
 TEST(pad, basic) {
   string const s = "Hello, world!";
   ASSERT_EQ(pad(s, 10), s);
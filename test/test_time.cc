@@ -0,0 +1,70 @@
+#include "fixfmt.hh"
+#include "gtest/gtest.h"
+
+using namespace fixfmt;
+
+TEST(TickDuration, basic) {
+  TickDuration fmt;
+  ASSERT_EQ(9u, fmt.get_width());
+  ASSERT_EQ(" 00:00:00", fmt(     0));
+  ASSERT_EQ(" 00:00:01", fmt(     1));
+  ASSERT_EQ("-00:00:01", fmt(    -1));
+  ASSERT_EQ(" 01:01:01", fmt(  3661));
+  ASSERT_EQ(" 99:59:59", fmt(359999));
+  ASSERT_EQ("#########", fmt(360000));
+  ASSERT_EQ("NaT      ", fmt(TickTime::NAT_VALUE));
+}
+
+TEST(TickDuration, precision) {
+  TickDuration fmt(TickTime::SCALE_NSEC, 3);
+  ASSERT_EQ(13u, fmt.get_width());
+  ASSERT_EQ(" 00:00:00.000", fmt(         0));
+  ASSERT_EQ(" 00:00:01.500", fmt(1500000000));
+  ASSERT_EQ("-00:00:01.500", fmt(-1500000000));
+  // Rounds half to even.
+  ASSERT_EQ(" 00:00:00.002", fmt(   1500000));
+  ASSERT_EQ(" 00:00:00.002", fmt(   2500000));
+  ASSERT_EQ(" 00:00:00.003", fmt(   2500001));
+  ASSERT_EQ(" 00:00:01.000", fmt( 999999999));
+
+  // More precision than the scale provides.
+  TickDuration fmt_ms(TickTime::SCALE_MSEC, 6);
+  ASSERT_EQ(" 00:00:01.234000", fmt_ms(1234));
+
+  // A decimal point with no fractional digits.
+  TickDuration fmt_0(TickTime::SCALE_SEC, 0);
+  ASSERT_EQ(" 00:01:00.", fmt_0(60));
+}
+
+TEST(TickDuration, days) {
+  TickDuration fmt(TickTime::SCALE_SEC, TickDuration::PRECISION_NONE, 3);
+  ASSERT_EQ(14u, fmt.get_width());
+  ASSERT_EQ("   0d 00:00:00", fmt(       0));
+  ASSERT_EQ("   1d 00:00:00", fmt(   86400));
+  ASSERT_EQ("  -1d 01:00:00", fmt(  -90000));
+  ASSERT_EQ(" 999d 23:59:59", fmt(86399999));
+  ASSERT_EQ("##############", fmt(86400000));
+}
+
+TEST(TickDuration, sign) {
+  TickDuration always(
+    TickTime::SCALE_SEC, TickDuration::PRECISION_NONE, 2,
+    TickDuration::SIGN_ALWAYS);
+  ASSERT_EQ(" +0d 00:00:05", always(      5));
+  ASSERT_EQ("-10d 00:00:00", always(-864000));
+
+  TickDuration none(
+    TickTime::SCALE_SEC, TickDuration::PRECISION_NONE, 0,
+    TickDuration::SIGN_NONE);
+  ASSERT_EQ(8u, none.get_width());
+  ASSERT_EQ("00:00:05", none( 5));
+  ASSERT_EQ("########", none(-5));
+}
+
+TEST(TickDuration, nat) {
+  TickDuration fmt(TickTime::SCALE_SEC, 2, 0, '-', "—");
+  ASSERT_EQ(12u, fmt.get_width());
+  ASSERT_EQ("—           ", fmt(TickTime::NAT_VALUE));
+  ASSERT_EQ(14u, fmt.get_max_bytes());
+}
+